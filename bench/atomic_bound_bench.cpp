@@ -0,0 +1,84 @@
+/*	Throughput of the lock-free counters against a bound behind a mutex, as the number of threads sharing one counter grows.
+
+		atomic_bound<int>				: compare and swap loop (saturating), against bound<int> and a std::mutex.
+		atomic_cyclic<unsigned> 0-1023	: power of two range, so fetch_add is a single atomic addition and a mask.
+		atomic_cyclic<unsigned> 0-999	: any other range, a compare and swap loop.
+		cyclic<unsigned> + mutex		: for each range, the same with a lock.
+
+	Each thread does the same number of fetch_add and fetch_sub (so the saturating counter stays clear of its limits),
+	all threads start together, and the time is that of the slowest. A standalone program, e.g.
+		g++ -std=c++17 -O2 -pthread -Iinclude bench/atomic_bound_bench.cpp -o atomic_bound_bench
+		./atomic_bound_bench [operations per thread]
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "atomic_bound.h"
+#include "cyclic.h"
+
+typedef std::chrono::steady_clock timer;
+
+// Runs body(ops) on each of n threads, released together, and returns the nanoseconds per operation over all the threads
+template <class Body> double run(int n, long ops, Body body)
+{
+	std::atomic<int> ready(0);
+	std::atomic<bool> go(false);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < n; ++t) threads.emplace_back([&] {
+		ready.fetch_add(1);
+		while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+		body(ops);
+	});
+	while (ready.load() != n) std::this_thread::yield();
+	timer::time_point start = timer::now();
+	go.store(true, std::memory_order_release);
+	for (std::thread& thread : threads) thread.join();
+	double ns = std::chrono::duration<double, std::nano>(timer::now() - start).count();
+	return ns / (double(ops) * n);
+}
+
+// A bound, or cyclic, behind a lock
+template <class B>
+struct locked {
+	B value;
+	std::mutex lock;
+
+	locked(const B& value) : value(value) {}
+	void add() { std::lock_guard<std::mutex> hold(lock); ++value; }
+	void sub() { std::lock_guard<std::mutex> hold(lock); --value; }
+};
+
+int main(int argc, char* argv[])
+{
+	long ops = argc > 1 ? std::atol(argv[1]) : 1L << 20;
+	if (ops < 2) ops = 2;
+
+	std::printf("ns per operation, %ld fetch_add and fetch_sub per thread\n\n", ops);
+	std::printf("%7s | %12s %12s | %12s %12s | %12s %12s\n", "threads", "atomic_bound", "bound+mutex", "cyclic 2^10", "cyclic+mutex", "cyclic 1000", "cyclic+mutex");
+	std::printf("--------+---------------------------+---------------------------+--------------------------\n");
+
+	for (int n = 1; n <= 64; n *= 2) {
+		atomic_bound<int> ab(0, -1000000000, 1000000000);
+		locked<bound<int>> lb(bound<int>(0, -1000000000, 1000000000));
+		atomic_cyclic<unsigned> masked(0, 0, 1023), cas(0, 0, 999);
+		locked<cyclic<unsigned>> lm(cyclic<unsigned>(0u, 0u, 1023u)), lc(cyclic<unsigned>(0u, 0u, 999u));
+
+		double t_ab = run(n, ops, [&](long k) { for (long i = 0; i < k; i += 2) { ab.fetch_add(1); ab.fetch_sub(1); } });
+		double t_lb = run(n, ops, [&](long k) { for (long i = 0; i < k; i += 2) { lb.add(); lb.sub(); } });
+		double t_masked = run(n, ops, [&](long k) { for (long i = 0; i < k; i += 2) { masked.fetch_add(1); masked.fetch_sub(1); } });
+		double t_lm = run(n, ops, [&](long k) { for (long i = 0; i < k; i += 2) { lm.add(); lm.sub(); } });
+		double t_cas = run(n, ops, [&](long k) { for (long i = 0; i < k; i += 2) { cas.fetch_add(1); cas.fetch_sub(1); } });
+		double t_lc = run(n, ops, [&](long k) { for (long i = 0; i < k; i += 2) { lc.add(); lc.sub(); } });
+
+		// Every thread undoes its own additions, so each counter must be back where it started
+		bool ok = ab.load() == 0 && lb.value.get() == 0 && masked.load() == 0 && lm.value.get() == 0 && cas.load() == 0 && lc.value.get() == 0;
+
+		std::printf("%7d | %12.2f %12.2f | %12.2f %12.2f | %12.2f %12.2f%s\n", n, t_ab, t_lb, t_masked, t_lm, t_cas, t_lc, ok ? "" : "  (counter did not return to 0)");
+	}
+	return 0;
+}
@@ -0,0 +1,100 @@
+/*	Time of fraction::simplify() by binary gcd (see gcd.h) against the trial division it replaced, for numerators from 1e2 to 2^31.
+
+	For each magnitude N, the fractions are num / den with num and den random in [N/2, N] (pairs with no common factor are
+	the slow case for trial division, which tries every odd number up to num / 2). Trial division takes up to seconds per
+	fraction for the largest numerators, so it runs over as many of the fractions as fit in a time budget, and the results
+	of the two are checked against each other: trial division never tries num itself, so e.g. 3/9 is left as it is, and
+	those fractions are counted as missed. A standalone program, e.g.
+		g++ -std=c++17 -O2 -Iinclude bench/simplify_bench.cpp -o simplify_bench
+		./simplify_bench [fractions per magnitude]
+*/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "fraction.h"
+
+typedef std::chrono::steady_clock timer;
+
+static const double budget = 0.5;		// seconds of trial division per magnitude
+
+// The simplify of fraction.cpp before the binary gcd: divide out 2, then every odd number up to num / 2
+static void trial_simplify(int& num, int& den)
+{
+	int max = std::ceil(num / 2);
+
+	// Divide by two until no longer possible
+	while (num % 2 == 0 && den % 2 == 0)
+	{
+		num /= 2; den /= 2;
+	}
+	max = std::ceil(num / 2);
+
+	// Check odd numbers onwards.
+	for (int i = 3; i < (max + 1); i+=2)
+	{
+		while (num % i == 0 && den % i == 0)
+		{
+			num /= i; den /= i;
+		}
+		max = std::ceil(num / 2);
+	}
+}
+
+static double seconds(timer::time_point start) { return std::chrono::duration<double>(timer::now() - start).count(); }
+
+int main(int argc, char* argv[])
+{
+	int count = argc > 1 ? std::atoi(argv[1]) : 10000;
+	if (count < 1) count = 1;
+
+	std::vector<long long> magnitudes;
+	for (long long n = 100; n <= 1000000000; n *= 10) magnitudes.push_back(n);
+	magnitudes.push_back(2147483647);		// 2^31 - 1, the largest int
+
+	std::mt19937 random(12345);
+	long long sink = 0;
+
+	std::printf("ns per simplify, %d fractions per magnitude (trial division within %.1f s)\n\n", count, budget);
+	std::printf("%12s | %14s %10s %8s | %14s | %10s\n", "numerator", "trial division", "(fractions)", "(missed)", "binary gcd", "speedup");
+	std::printf("-------------+-------------------------------------+----------------+-----------\n");
+
+	for (long long n : magnitudes) {
+		std::uniform_int_distribution<int> pick(int(n / 2), int(n));
+		std::vector<fraction> fractions;
+		for (int i = 0; i < count; ++i) fractions.push_back(fraction(pick(random), pick(random)));
+
+		// Binary gcd, over all the fractions
+		std::vector<fraction> reduced(fractions);
+		timer::time_point start = timer::now();
+		for (fraction& f : reduced) f.simplify();
+		double t_gcd = seconds(start) * 1e9 / count;
+
+		// Trial division, for as long as the budget allows (the clock is read for each of the first 16 fractions, then once every 16)
+		std::vector<int> nums, dens;
+		for (const fraction& f : fractions) { nums.push_back(f.get_num()); dens.push_back(f.get_den()); }
+		int done = 0;
+		start = timer::now();
+		while (done < count && (done == 0 || (done >= 16 && done % 16 != 0) || seconds(start) < budget)) {
+			trial_simplify(nums[done], dens[done]);
+			++done;
+		}
+		double t_trial = seconds(start) * 1e9 / done;
+
+		int missed = 0, wrong = 0;
+		for (int i = 0; i < done; ++i) {
+			const fraction& r = reduced[i];
+			sink += nums[i];
+			if (nums[i] == r.get_num() && dens[i] == r.get_den()) continue;
+			if (nums[i] % r.get_num() == 0 && dens[i] == nums[i] / r.get_num() * r.get_den()) ++missed;		// the same fraction, not in lowest terms
+			else ++wrong;
+		}
+
+		for (const fraction& f : reduced) sink += f.get_num();
+		std::printf("%12lld | %14.0f %10d %8d | %14.1f | %9.0fx%s\n", n, t_trial, done, missed, t_gcd, t_trial / t_gcd, wrong ? "  (results differ)" : "");
+	}
+	return sink == 0;		// keep the results live
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <atomic>
+#include <type_traits>
+#include "cyclic.h"
+#include "int_traits.h"
+
+/*	Bound and cyclic counters that can be shared between threads without a lock, e.g. for quotas, rate limiters and ring indices.
+
+		atomic_bound<T, Policy>	: a value in [min, max], updated with a compare and swap loop that applies the policy,
+								  saturating at the limits by default (bound_saturate, so an integer overflow also saturates).
+		atomic_cyclic<T>		: an integer that cycles through [min, max]. If the size of the range is a power of two
+								  (or the whole of T) fetch_add is a single atomic addition, and the wrap is a mask
+								  applied when the value is read; otherwise it is a compare and swap loop.
+
+	Every operation takes a std::memory_order (std::memory_order_seq_cst by default), as std::atomic does. fetch_add and fetch_sub
+	return the value before the operation, and the operators the value after it.
+
+	Example use:
+		atomic_bound<int> tokens(100, 0, 100);
+		if (tokens.fetch_sub(1, std::memory_order_acquire) > 0) { ... }		// took a token (the count stops at 0)
+
+		atomic_cyclic<unsigned> slot(0, 0, 1023);
+		unsigned i = slot.fetch_add(1, std::memory_order_relaxed);			// ring buffer index, one lock xadd
+*/
+
+// The order for the load of a failed compare and swap (and the first load of the loop), given the order of the operation.
+inline constexpr std::memory_order failure_order(std::memory_order order) noexcept
+{
+	return order == std::memory_order_acq_rel ? std::memory_order_acquire : (order == std::memory_order_release ? std::memory_order_relaxed : order);
+}
+
+template <class T, class Policy = bound_saturate>
+class atomic_bound {
+	static_assert(std::is_arithmetic<T>::value, "atomic_bound requires an integer or floating point type");
+
+	std::atomic<T> val;
+	const T min, max;
+
+	T checked(T x) const { Policy::check(x, min, max); return x; }
+
+	template <class Op> T update(Op op, std::memory_order order)
+	{
+		T old = val.load(failure_order(order));
+		for (;;) {
+			T next = old;
+			op(next);
+			Policy::check(next, min, max);
+			if (next == old) return old;		// already at the limit, e.g. an exhausted quota: nothing to write, so no contention for the cache line
+			if (val.compare_exchange_weak(old, next, order, failure_order(order))) return old;
+		}
+	}
+
+public:
+	typedef T value_type;
+	typedef Policy policy;
+
+	atomic_bound(const T& val, const T& min, const T& max) : val(), min(min), max(max) { this->val.store(checked(val), std::memory_order_relaxed); }
+	atomic_bound(const atomic_bound&) = delete;
+	atomic_bound& operator = (const atomic_bound&) = delete;
+
+	static constexpr bool is_always_lock_free = std::atomic<T>::is_always_lock_free;
+	bool is_lock_free() const noexcept { return val.is_lock_free(); }
+
+	// Accessors
+
+	T load(std::memory_order order = std::memory_order_seq_cst) const noexcept { return val.load(order); }
+	void store(const T& x, std::memory_order order = std::memory_order_seq_cst) { val.store(checked(x), order); }
+	T exchange(const T& x, std::memory_order order = std::memory_order_seq_cst) { return val.exchange(checked(x), order); }
+
+	const T& get_min() const noexcept { return min; }
+	const T& get_max() const noexcept { return max; }
+	bound<T, Policy> snapshot(std::memory_order order = std::memory_order_seq_cst) const { return bound<T, Policy>(val.load(order), min, max); }
+
+	operator T() const noexcept { return load(); }
+
+	// Functions
+
+	T fetch_add(const T& rhs, std::memory_order order = std::memory_order_seq_cst) { return update([&](T& x) { Policy::add(x, rhs, min, max); }, order); }
+	T fetch_sub(const T& rhs, std::memory_order order = std::memory_order_seq_cst) { return update([&](T& x) { Policy::sub(x, rhs, min, max); }, order); }
+	T fetch_mul(const T& rhs, std::memory_order order = std::memory_order_seq_cst) { return update([&](T& x) { Policy::mul(x, rhs); }, order); }
+	T fetch_div(const T& rhs, std::memory_order order = std::memory_order_seq_cst) { return update([&](T& x) { Policy::div(x, rhs); }, order); }
+
+	// Operator overloads
+
+	T operator = (const T& rhs) { T x = checked(rhs); val.store(x); return x; }
+	T operator += (const T& rhs) { T x = fetch_add(rhs); Policy::add(x, rhs, min, max); return checked(x); }
+	T operator -= (const T& rhs) { T x = fetch_sub(rhs); Policy::sub(x, rhs, min, max); return checked(x); }
+
+	T operator++() { return *this += T(1); }
+	T operator--() { return *this -= T(1); }
+	T operator++(int) { return fetch_add(T(1)); }
+	T operator--(int) { return fetch_sub(T(1)); }
+};
+
+template <class T>
+class atomic_cyclic {
+	static_assert(is_integer<T>::value && sizeof(T) <= sizeof(std::uint64_t), "atomic_cyclic requires an integer type of up to 64 bits");
+	typedef typename unsigned_of<T>::type U;
+
+	std::atomic<U> offset;		// from min: reduced modulo size, or (for a power of two size) free running, and masked when read
+	const T min, max;
+	const U size;				// max - min + 1, or 0 if the range is all of T
+	const bool masked;			// size is a power of two (or 0)
+
+	T value(U x) const noexcept { return T(U(U(min) + (masked ? x & U(size - 1) : x))); }
+
+	// rhs modulo size, as an unsigned step forwards (fetch_sub steps forwards by -rhs)
+	U step(T rhs, bool negate) const noexcept
+	{
+		if (masked) return negate ? U(U(0) - U(rhs)) : U(rhs);
+		U back = 0, forward = 0;
+		if ((rhs < T(0)) != negate) back = U(rhs < T(0) ? U(0) - U(rhs) : U(rhs)) % size;
+		else forward = U(rhs < T(0) ? U(0) - U(rhs) : U(rhs)) % size;
+		return back == 0 ? forward : size - back;
+	}
+
+	// old + forward modulo size, without overflow (old, forward < size)
+	U next(U old, U forward) const noexcept { return masked ? U(old + forward) : (old >= size - forward ? old - (size - forward) : old + forward); }
+
+	// Advance the offset, and return its old value
+	U advance(U forward, std::memory_order order)
+	{
+		if (masked) return offset.fetch_add(forward, order);
+		U old = offset.load(failure_order(order));
+		while (!offset.compare_exchange_weak(old, next(old, forward), order, failure_order(order))) {}
+		return old;
+	}
+
+public:
+	typedef T value_type;
+
+	atomic_cyclic(const T& val, const T& min, const T& max) : offset(), min(min), max(max), size(U(U(max) - U(min) + 1)), masked((size & U(size - 1)) == 0)
+	{
+		offset.store(U(U(wrap(val, min, max)) - U(min)), std::memory_order_relaxed);
+	}
+	atomic_cyclic(const atomic_cyclic&) = delete;
+	atomic_cyclic& operator = (const atomic_cyclic&) = delete;
+
+	static constexpr bool is_always_lock_free = std::atomic<U>::is_always_lock_free;
+	bool is_lock_free() const noexcept { return offset.is_lock_free(); }
+	bool single_instruction() const noexcept { return masked; }		// fetch_add and fetch_sub are a single atomic addition
+
+	// Accessors
+
+	T load(std::memory_order order = std::memory_order_seq_cst) const noexcept { return value(offset.load(order)); }
+	void store(const T& x, std::memory_order order = std::memory_order_seq_cst) { offset.store(U(U(wrap(x, min, max)) - U(min)), order); }
+	T exchange(const T& x, std::memory_order order = std::memory_order_seq_cst) { return value(offset.exchange(U(U(wrap(x, min, max)) - U(min)), order)); }
+
+	const T& get_min() const noexcept { return min; }
+	const T& get_max() const noexcept { return max; }
+	cyclic<T> snapshot(std::memory_order order = std::memory_order_seq_cst) const { return cyclic<T>(load(order), min, max); }
+
+	operator T() const noexcept { return load(); }
+
+	// Functions
+
+	T fetch_add(const T& rhs, std::memory_order order = std::memory_order_seq_cst) { return value(advance(step(rhs, false), order)); }
+	T fetch_sub(const T& rhs, std::memory_order order = std::memory_order_seq_cst) { return value(advance(step(rhs, true), order)); }
+
+	// Operator overloads
+
+	T operator = (const T& rhs) { store(rhs); return wrap(rhs, min, max); }
+	T operator += (const T& rhs) { U forward = step(rhs, false); return value(next(advance(forward, std::memory_order_seq_cst), forward)); }
+	T operator -= (const T& rhs) { U forward = step(rhs, true);  return value(next(advance(forward, std::memory_order_seq_cst), forward)); }
+
+	T operator++() { return *this += T(1); }
+	T operator--() { return *this -= T(1); }
+	T operator++(int) { return fetch_add(T(1)); }
+	T operator--(int) { return fetch_sub(T(1)); }
+};
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <stdexcept>
+#include "big_int.h"
+#include "fraction.h"
+#include "gcd.h"
+
+/*	An exact fraction of arbitrary precision integers, e.g. 2^100 / 3, that never overflows.
+
+	Always kept in lowest terms with a positive denominator, so equal values have equal terms.
+	Addition and multiplication follow Knuth (TAOCP vol. 2, 4.5.1): the gcds are taken of the
+	operands' terms before combining them, so they stay as small as possible.
+
+	While both terms fit in 64 bits (the common case), the arithmetic is done inline with 128 bit
+	intermediates and no allocation. Otherwise it falls back to big_int (see big_fraction.cpp).
+
+	Converts losslessly from any basic_fraction, and back with to_fraction<F>() when the value fits.
+
+	Example use:
+		big_fraction f = fraction(1, 3);
+		for (int i = 0; i < 100; ++i) f *= fraction(1, 3);	// 1/3^101, which no built-in integer could hold
+		f.to_double();										// 6.47e-49
+*/
+class big_fraction
+{
+private:
+	big_int num, den;
+
+	bool is_small() const noexcept { return num.is_small() && den.is_small(); }
+	void normalise();
+	void add_slow(const big_fraction& rhs, bool subtract);
+	void multiply_slow(const big_int& rhs_num, const big_int& rhs_den);
+
+	static big_fraction from_terms(const big_int& num, const big_int& den) { big_fraction f; f.num = num; f.den = den; return f; }	// terms already in lowest terms
+
+#if HAS_INT128
+	void set(int128_t n, int128_t d) { num = big_int(n); den = big_int(d); }
+#endif
+
+public:
+
+	// Construction
+
+	big_fraction() : num(0), den(1) {}
+	big_fraction(const big_int& num, const big_int& den = big_int(1)) : num(num), den(den) { normalise(); }
+	template <class I, class N, class O> big_fraction(const basic_fraction<I, N, O>& f) : num(f.get_num()), den(f.get_den()) { normalise(); }
+
+	// Accessors
+
+	const big_int& get_num() const noexcept { return num; }
+	const big_int& get_den() const noexcept { return den; }
+
+	// Type casts
+
+	double to_double() const;
+	str to_string() const;
+
+	template <class F> bool fits() const noexcept		// true if the value can be held by the basic_fraction F
+	{
+		typedef typename F::int_type I;
+		return num.fits<I>() && den.fits<I>();
+	}
+	template <class F> F to_fraction() const			// throws std::overflow_error if the value does not fit in F
+	{
+		typedef typename F::int_type I;
+		if (!fits<F>()) throw std::overflow_error("big_fraction does not fit");
+		return F(num.to_int<I>(), den.to_int<I>());
+	}
+
+	// Functions
+
+	big_fraction& invert();
+	big_fraction& negate() { num.negate(); return *this; }
+
+	// Operator overloads
+
+	bool operator == (const big_fraction& rhs) const { return num == rhs.num && den == rhs.den; }
+	bool operator != (const big_fraction& rhs) const { return !operator==(rhs); }
+	bool operator <  (const big_fraction& rhs) const;
+	bool operator >  (const big_fraction& rhs) const { return rhs < *this; }
+	bool operator <= (const big_fraction& rhs) const { return !operator>(rhs); }
+	bool operator >= (const big_fraction& rhs) const { return !operator<(rhs); }
+
+	big_fraction operator-() const { big_fraction result(*this); result.negate(); return result; }
+
+	big_fraction& operator += (const big_fraction& rhs);
+	big_fraction& operator -= (const big_fraction& rhs);
+	big_fraction& operator *= (const big_fraction& rhs);
+	big_fraction& operator /= (const big_fraction& rhs);
+};
+
+// Inline fast paths
+
+inline bool big_fraction::operator < (const big_fraction& rhs) const
+{
+#if HAS_INT128
+	if (is_small() && rhs.is_small())
+		return int128_t(num.get_small()) * rhs.den.get_small() < int128_t(rhs.num.get_small()) * den.get_small();
+#endif
+	return num * rhs.den < rhs.num * den;
+}
+
+inline big_fraction& big_fraction::operator += (const big_fraction& rhs)
+{
+#if HAS_INT128
+	if (is_small() && rhs.is_small())
+	{
+		std::int64_t a = num.get_small(), b = den.get_small(), c = rhs.num.get_small(), d = rhs.den.get_small();
+		std::int64_t g = gcd(b, d);
+		if (g == 1) set(int128_t(a) * d + int128_t(c) * b, int128_t(b) * d);		// already in lowest terms
+		else
+		{
+			int128_t t = int128_t(a) * (d / g) + int128_t(c) * (b / g);
+			std::int64_t h = gcd(std::int64_t(t % g), g);
+			set(t / h, int128_t(b / g) * (d / h));
+		}
+		return *this;
+	}
+#endif
+	add_slow(rhs, false);
+	return *this;
+}
+
+inline big_fraction& big_fraction::operator -= (const big_fraction& rhs)
+{
+#if HAS_INT128
+	if (rhs.is_small() && rhs.num.get_small() != INT64_MIN) return *this += -rhs;
+#endif
+	add_slow(rhs, true);
+	return *this;
+}
+
+inline big_fraction& big_fraction::operator *= (const big_fraction& rhs)
+{
+#if HAS_INT128
+	if (is_small() && rhs.is_small())
+	{
+		std::int64_t a = num.get_small(), b = den.get_small(), c = rhs.num.get_small(), d = rhs.den.get_small();
+		if (a == 0 || c == 0) { num = 0; den = 1; return *this; }
+		std::int64_t g = gcd(a, d), h = gcd(c, b);		// cross-cancel, then the product is in lowest terms
+		set(int128_t(a / g) * (c / h), int128_t(b / h) * (d / g));
+		return *this;
+	}
+#endif
+	multiply_slow(rhs.num, rhs.den);
+	return *this;
+}
+
+inline big_fraction& big_fraction::operator /= (const big_fraction& rhs)
+{
+	if (rhs.num.sign() == 0) throw std::domain_error("big_fraction: division by zero");
+	if (rhs.num.sign() > 0) *this *= big_fraction::from_terms(rhs.den, rhs.num);
+	else *this *= big_fraction::from_terms(-rhs.den, -rhs.num);
+	return *this;
+}
+
+// Operator overloads : rhs arithmetic
+
+inline big_fraction operator+ (big_fraction lhs, const big_fraction& rhs) { lhs += rhs; return lhs; }
+inline big_fraction operator- (big_fraction lhs, const big_fraction& rhs) { lhs -= rhs; return lhs; }
+inline big_fraction operator* (big_fraction lhs, const big_fraction& rhs) { lhs *= rhs; return lhs; }
+inline big_fraction operator/ (big_fraction lhs, const big_fraction& rhs) { lhs /= rhs; return lhs; }
+
+std::ostream& operator << (std::ostream& os, const big_fraction& rhs);
+std::istream& operator >> (std::istream& in, big_fraction& rhs);
@@ -0,0 +1,159 @@
+#pragma once
+
+// To do
+//		- Karatsuba multiplication for very large operands (schoolbook is used throughout).
+//		- half-gcd, which only pays off for operands of thousands of digits (Lehmer's algorithm is used).
+
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+#include "int_traits.h"
+#include "typedefs.h"
+
+/*	An arbitrary precision integer.
+
+	Values that fit in 64 bits are stored inline (in small) and never allocate, so the common case
+	costs one overflow-checked machine instruction per operation. Values that overflow are moved into
+	a vector of 32 bit limbs (sign and magnitude), and move back inline as soon as they fit again.
+
+	Example use:
+		big_int a = std::int64_t(1) << 62;
+		a *= a;					// 2^124, now stored in limbs
+		a /= a;					// 1, back inline
+		gcd(big_int("123456789012345678901234567890"), big_int(90));	// 90
+
+	Division truncates towards zero, and % takes the sign of the dividend (like the built-in integers).
+	Implementation of the large (limb) cases is in big_int.cpp.
+*/
+class big_int
+{
+public:
+	typedef std::uint32_t limb;
+	typedef std::vector<limb> magnitude;
+
+private:
+	std::int64_t small;		// the value, while it fits in 64 bits (limbs is then empty)
+	magnitude limbs;		// otherwise the magnitude, least significant limb first
+	bool negative;			// the sign, when the value is in limbs
+
+	void assign(bool negative, magnitude&& m);			// stores m, inline if it fits
+	void assign_u64(bool negative, std::uint64_t m);
+	magnitude get_magnitude() const;
+
+	void add_slow(const big_int& rhs, bool subtract);
+	void mul_slow(const big_int& rhs);
+	static int compare_slow(const big_int& lhs, const big_int& rhs);
+
+	friend big_int gcd(const big_int& a, const big_int& b);
+
+public:
+
+	// Construction
+
+	big_int() noexcept : small(0), limbs(), negative(false) {}
+	template <class I, class = typename std::enable_if<is_integer<I>::value>::type> big_int(I x) : small(0), limbs(), negative(false)
+	{
+		if (::fits<std::int64_t>(x)) small = std::int64_t(x);
+		else assign(x < 0, to_magnitude(x));
+	}
+	explicit big_int(const str& digits);
+
+	// Accessors
+
+	bool is_small() const noexcept { return limbs.empty(); }		// true if the value is stored inline
+	std::int64_t get_small() const noexcept { return small; }	// the value, if is_small()
+	const magnitude& get_limbs() const noexcept { return limbs; }	// the magnitude, if !is_small()
+	int sign() const noexcept { return is_small() ? (small > 0) - (small < 0) : (negative ? -1 : 1); }
+	std::size_t bits() const noexcept;								// number of bits in the magnitude
+
+	template <class I> bool fits() const noexcept		// true if the value can be represented by the signed integer I
+	{
+		if (is_small()) return ::fits<I>(small);
+		std::size_t digits = int_limits<I>::digits;
+		return bits() <= digits || (negative && bits() == digits + 1 && is_power_of_2());
+	}
+
+	// Type casts
+
+	template <class I> I to_int() const noexcept		// wraps (two's complement) if the value does not fit in I
+	{
+		if (is_small()) return I(small);
+		typedef typename unsigned_of<I>::type U;
+		U m = 0;
+		for (std::size_t i = limbs.size(); i-- > 0;) m = U(m << 16 << 16) | U(limbs[i]);
+		return negative ? I(U(0) - m) : I(m);
+	}
+	double to_double() const;
+	str to_string() const;
+
+	template <class U> static magnitude to_magnitude(U x)
+	{
+		typedef typename unsigned_of<U>::type M;
+		M m = x < 0 ? M(0) - M(x) : M(x);
+		magnitude result;
+		while (m != 0) { result.push_back(limb(m)); m = M(m >> 16 >> 16); }
+		return result;
+	}
+
+	// Functions
+
+	bool is_power_of_2() const noexcept;
+	big_int& negate();
+	big_int& abs() { if (sign() < 0) negate(); return *this; }
+	static void divmod(const big_int& dividend, const big_int& divisor, big_int& quotient, big_int& remainder);
+
+	// Operator overloads
+
+	bool operator == (const big_int& rhs) const { return (is_small() && rhs.is_small()) ? small == rhs.small : compare_slow(*this, rhs) == 0; }
+	bool operator != (const big_int& rhs) const { return !operator==(rhs); }
+	bool operator <  (const big_int& rhs) const { return (is_small() && rhs.is_small()) ? small < rhs.small : compare_slow(*this, rhs) < 0; }
+	bool operator >  (const big_int& rhs) const { return rhs < *this; }
+	bool operator <= (const big_int& rhs) const { return !operator>(rhs); }
+	bool operator >= (const big_int& rhs) const { return !operator<(rhs); }
+
+	big_int operator-() const { big_int result(*this); result.negate(); return result; }
+	big_int& operator++() { return *this += 1; }
+	big_int& operator--() { return *this -= 1; }
+	const big_int operator++(int) { big_int result(*this); ++(*this); return result; }
+	const big_int operator--(int) { big_int result(*this); --(*this); return result; }
+
+	big_int& operator += (const big_int& rhs) {
+		std::int64_t result;
+		if (is_small() && rhs.is_small() && !checked_add(small, rhs.small, result)) small = result;
+		else add_slow(rhs, false);
+		return *this;
+	}
+	big_int& operator -= (const big_int& rhs) {
+		std::int64_t result;
+		if (is_small() && rhs.is_small() && !checked_sub(small, rhs.small, result)) small = result;
+		else add_slow(rhs, true);
+		return *this;
+	}
+	big_int& operator *= (const big_int& rhs) {
+		std::int64_t result;
+		if (is_small() && rhs.is_small() && !checked_mul(small, rhs.small, result)) small = result;
+		else mul_slow(rhs);
+		return *this;
+	}
+	big_int& operator /= (const big_int& rhs);
+	big_int& operator %= (const big_int& rhs);
+	big_int& operator <<= (std::size_t shift);		// shifts the magnitude, i.e. multiplies by 2^shift
+	big_int& operator >>= (std::size_t shift);		// shifts the magnitude, i.e. divides by 2^shift (truncating towards zero)
+};
+
+// Return the greatest common divisor of the magnitudes of a and b (binary gcd inline, Lehmer's algorithm for limbs).
+big_int gcd(const big_int& a, const big_int& b);
+
+// Operator overloads : rhs arithmetic
+
+inline big_int operator+ (big_int lhs, const big_int& rhs) { lhs += rhs; return lhs; }
+inline big_int operator- (big_int lhs, const big_int& rhs) { lhs -= rhs; return lhs; }
+inline big_int operator* (big_int lhs, const big_int& rhs) { lhs *= rhs; return lhs; }
+inline big_int operator/ (big_int lhs, const big_int& rhs) { lhs /= rhs; return lhs; }
+inline big_int operator% (big_int lhs, const big_int& rhs) { lhs %= rhs; return lhs; }
+inline big_int operator<< (big_int lhs, std::size_t shift) { lhs <<= shift; return lhs; }
+inline big_int operator>> (big_int lhs, std::size_t shift) { lhs >>= shift; return lhs; }
+
+std::ostream& operator << (std::ostream& os, const big_int& rhs);
+std::istream& operator >> (std::istream& in, big_int& rhs);
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include "cyclic.h"
+
+/*	A binary angle (binary angular measurement, BAM): an angle stored as an unsigned N bit integer count of 1 / 2^N turns.
+	The whole circle maps onto the whole integer, so angles wrap round for free, with the integer's own overflow,
+	and additions and subtractions are exact. E.g. for binary_angle<16>, 0x4000 is 90 degrees and 0xC000 + 0x8000 = 0x4000.
+
+		N	: the number of bits, from 2 to 64. Stored in the smallest unsigned type that holds N bits
+			  (and kept within N bits, so binary_angle<12> wraps at 4096).
+
+	The sin, cos and atan2 below are faster than std::sin, std::cos and std::atan2 and need no range reduction:
+		sin, cos	: a table of 256 sines (one per 1/256 turn) and short series for the remaining angle, of at most 1/512 turn:
+					  sin(a + d) = sin(a) cos(d) + cos(a) sin(d). Error at most 1e-15 (a few units in the last place of a double).
+		atan2		: a table of 33 arctangents, and a short series after reducing to within 1/64 of a table point. Error at most 1e-15
+					  radians before the result is rounded to the nearest binary angle (half of 2 pi / 2^N).
+
+	Converts to and from radians, degrees and turns (rounding to the nearest binary angle), and to and from cyclic<double> of any range:
+		binary_angle<32> a = binary_angle<32>::from_radians(constant::pi);		// half a turn, exactly, as 0x80000000
+		cyclic<double> c = a.to_cyclic();		// pi, in [0, 2 pi)
+	constant::pi and its multiples (see science/constants.h) are rounded to 12 digits or fewer, which is still within
+	half a binary angle for N up to 32, so they convert to exactly half (or a quarter, ...) of a turn.
+*/
+template <int N>
+class binary_angle {
+	static_assert(N >= 2 && N <= 64, "binary_angle requires from 2 to 64 bits");
+
+public:
+	typedef typename std::conditional<(N <= 8), std::uint8_t,
+			typename std::conditional<(N <= 16), std::uint16_t,
+			typename std::conditional<(N <= 32), std::uint32_t, std::uint64_t>::type>::type>::type raw_type;
+
+	static constexpr int bits = N;
+	static constexpr double two_pi = 6.283185307179586476925286766559;
+	static constexpr double units_per_turn = double(std::uint64_t(1) << (N - 1)) * 2;		// 2^N, exactly
+
+private:
+	static constexpr raw_type mask = raw_type(~std::uint64_t(0) >> (64 - N));
+
+	raw_type raw;
+
+	struct from_raw_tag {};
+	constexpr binary_angle(raw_type r, from_raw_tag) noexcept : raw(raw_type(r & mask)) {}
+
+public:
+
+	// Construction
+
+	constexpr binary_angle() noexcept : raw(0) {}
+	explicit binary_angle(const cyclic<double>& c) : binary_angle(from_turns((c.get() - c.get_min()) / (c.get_max() - c.get_min()))) {}
+
+	static constexpr binary_angle from_raw(raw_type r) noexcept { return binary_angle(r, from_raw_tag()); }
+	static binary_angle from_turns(double turns);		// rounded to the nearest binary angle
+	static binary_angle from_radians(double radians) { return from_turns(radians / two_pi); }
+	static binary_angle from_degrees(double degrees) { return from_turns(degrees / 360.0); }
+
+	static constexpr binary_angle quarter_turn() noexcept { return from_raw(raw_type(std::uint64_t(1) << (N - 2))); }
+	static constexpr binary_angle half_turn() noexcept { return from_raw(raw_type(std::uint64_t(1) << (N - 1))); }
+
+	// Accessors
+
+	constexpr raw_type get_raw() const noexcept { return raw; }
+	constexpr std::int64_t get_signed_raw() const noexcept { return std::int64_t(std::uint64_t(raw) << (64 - N)) >> (64 - N); }		// in [-2^(N-1), 2^(N-1))
+
+	// Type casts
+
+	double to_turns() const { return double(raw) / units_per_turn; }							// in [0, 1)
+	double to_radians() const { return to_turns() * two_pi; }									// in [0, 2 pi)
+	double to_signed_radians() const { return double(get_signed_raw()) / units_per_turn * two_pi; }		// in [-pi, pi)
+	double to_degrees() const { return to_turns() * 360.0; }
+	cyclic<double> to_cyclic(double min = 0.0, double max = two_pi) const { return cyclic<double>(min + to_turns() * (max - min), min, max); }
+	std::string to_string() const { return std::to_string(to_degrees()); }
+
+	// Operator overloads
+
+	constexpr bool operator == (const binary_angle& rhs) const noexcept { return raw == rhs.raw; }
+	constexpr bool operator != (const binary_angle& rhs) const noexcept { return raw != rhs.raw; }
+	constexpr bool operator <  (const binary_angle& rhs) const noexcept { return raw <  rhs.raw; }		// as for cyclic: by the angle in [0, 2 pi)
+	constexpr bool operator >  (const binary_angle& rhs) const noexcept { return raw >  rhs.raw; }
+	constexpr bool operator <= (const binary_angle& rhs) const noexcept { return raw <= rhs.raw; }
+	constexpr bool operator >= (const binary_angle& rhs) const noexcept { return raw >= rhs.raw; }
+
+	constexpr binary_angle operator-() const noexcept { return from_raw(raw_type(0u - raw)); }
+
+	constexpr binary_angle& operator += (const binary_angle& rhs) noexcept { raw = raw_type((raw + rhs.raw) & mask); return *this; }
+	constexpr binary_angle& operator -= (const binary_angle& rhs) noexcept { raw = raw_type((raw - rhs.raw) & mask); return *this; }
+	constexpr binary_angle& operator *= (std::int64_t rhs) noexcept { raw = raw_type((std::uint64_t(raw) * std::uint64_t(rhs)) & mask); return *this; }
+	constexpr binary_angle& operator /= (std::uint64_t rhs) noexcept { raw = raw_type(raw / rhs); return *this; }		// rounds down
+
+	constexpr binary_angle& operator++() noexcept { raw = raw_type((raw + 1u) & mask); return *this; }		// by one unit, 1 / 2^N turns
+	constexpr binary_angle& operator--() noexcept { raw = raw_type((raw - 1u) & mask); return *this; }
+};
+
+template <int N> binary_angle<N> binary_angle<N>::from_turns(double turns)
+{
+	double scaled = turns * units_per_turn;
+	if (N <= 32 && std::fabs(scaled) < 0x1p51) {
+		// Adding 1.5 * 2^52 rounds to the nearest integer, which is left in the low bits of the mantissa (in two's complement,
+		// so the low N bits are the angle, whatever the sign or number of turns). No branches, as the sign is seldom predictable.
+		std::uint64_t bits = 0;
+		double rounded = scaled + 0x1.8p52;
+		std::memcpy(&bits, &rounded, sizeof(bits));
+		return from_raw(raw_type(bits));
+	}
+	scaled = std::nearbyint((turns - std::floor(turns)) * units_per_turn);		// in [0, 2^N]
+	if (!(scaled < units_per_turn)) scaled = 0;		// a whole turn (or NaN)
+	return from_raw(raw_type(std::uint64_t(scaled)));
+}
+
+// Operator overloads : rhs arithmetic
+
+template <int N> constexpr binary_angle<N> operator+ (binary_angle<N> lhs, const binary_angle<N>& rhs) noexcept { lhs += rhs; return lhs; }
+template <int N> constexpr binary_angle<N> operator- (binary_angle<N> lhs, const binary_angle<N>& rhs) noexcept { lhs -= rhs; return lhs; }
+template <int N> constexpr binary_angle<N> operator* (binary_angle<N> lhs, std::int64_t rhs) noexcept { lhs *= rhs; return lhs; }
+template <int N> constexpr binary_angle<N> operator* (std::int64_t lhs, binary_angle<N> rhs) noexcept { rhs *= lhs; return rhs; }
+template <int N> constexpr binary_angle<N> operator/ (binary_angle<N> lhs, std::uint64_t rhs) noexcept { lhs /= rhs; return lhs; }
+
+template <int N> std::ostream& operator << (std::ostream& os, const binary_angle<N>& a) { os << a.to_degrees() << " deg"; return os; }
+
+typedef binary_angle<16> angle16;
+typedef binary_angle<32> angle32;
+
+// Trigonometry
+//------------------------------------------------------------------------------------
+
+namespace binary_angle_tables {
+
+	const int sine_bits = 8;
+	const int sines = 1 << sine_bits;		// one per 1/256 turn
+	const int arctangents = 32;				// atan(k / 32) for k = 0 to 32
+
+	struct tables {
+		double sine[sines];
+		double arctangent[arctangents + 1];
+		double octant_offset[8], octant_sign[8];		// the angle in turns is offset + sign * t, for t in the first octant
+		tables()
+		{
+			for (int i = 0; i < sines; ++i) sine[i] = std::sin(binary_angle<sine_bits>::two_pi * i / sines);
+			for (int k = 0; k <= arctangents; ++k) arctangent[k] = std::atan(double(k) / arctangents);
+			for (int o = 0; o < 8; ++o) {
+				double offset = 0, sign = 1;
+				if (o & 1) { offset = 0.25 - offset; sign = -sign; }		// |y| > |x|
+				if (o & 2) { offset = 0.5 - offset; sign = -sign; }		// x < 0
+				if (o & 4) { offset = -offset; sign = -sign; }			// y < 0
+				octant_offset[o] = offset;
+				octant_sign[o] = sign;
+			}
+		}
+	};
+
+	inline const tables& get() { static const tables t; return t; }
+}
+
+// sin and cos of a together: the nearest table angle, and the remaining angle d (at most 1/512 turn, 0.0123 radians) by series,
+// whose first omitted terms (d^7 / 5040 and d^8 / 40320) are below 1e-17, so the error is that of rounding.
+template <int N> void sincos(const binary_angle<N>& a, double& sine, double& cosine)
+{
+	using namespace binary_angle_tables;
+	const tables& t = get();
+	std::uint64_t raw = a.get_raw();
+	int i = 0;
+	double d = 0;
+	if constexpr (N <= sine_bits) i = int(raw << (sine_bits - N));
+	else {
+		const int shift = N - sine_bits;
+		std::uint64_t nearest = (raw + (std::uint64_t(1) << (shift - 1))) >> shift;		// rounded, so the remainder is signed
+		i = int(nearest & (sines - 1));
+		std::int64_t rest = std::int64_t(raw - (nearest << shift));
+		d = double(rest) * (binary_angle<N>::two_pi / binary_angle<N>::units_per_turn);
+	}
+	double s = t.sine[i], c = t.sine[(i + sines / 4) & (sines - 1)];
+	if (d == 0) { sine = s; cosine = c; return; }
+	double d2 = d * d;
+	double sin_d = d * (1 - d2 * (1.0 / 6) * (1 - d2 * (1.0 / 20)));					// d - d^3/6 + d^5/120
+	double cos_d_minus_1 = -d2 * 0.5 * (1 - d2 * (1.0 / 12) * (1 - d2 * (1.0 / 30)));		// -d^2/2 + d^4/24 - d^6/720
+	sine = s + (s * cos_d_minus_1 + c * sin_d);
+	cosine = c + (c * cos_d_minus_1 - s * sin_d);
+}
+
+template <int N> double sin(const binary_angle<N>& a) { double s, c; sincos(a, s, c); return s; }
+template <int N> double cos(const binary_angle<N>& a) { double s, c; sincos(a, s, c); return c; }
+
+// The angle of the point (x, y), as std::atan2(y, x), rounded to the nearest binary angle.
+// Reduced to the first octant (z = the smaller of |x| and |y| over the larger, in [0, 1]), then to within 1/64 of a table point c:
+// atan(z) = atan(c) + atan(t), with t = (z - c) / (1 + z c), and atan(t) = t - t^3/3 + t^5/5 - t^7/7, whose next term is below 3e-18.
+template <int N> binary_angle<N> atan2(double y, double x)
+{
+	using namespace binary_angle_tables;
+	double ax = std::fabs(x), ay = std::fabs(y);
+	if (ax == 0 && ay == 0) return binary_angle<N>();
+	double z = std::min(ax, ay) / std::max(ax, ay);
+	if (!(z <= 1)) z = 1;		// both infinite (or NaN)
+	int k = int(z * arctangents + 0.5);
+	double c = double(k) * (1.0 / arctangents), u = (z - c) / (1 + z * c), u2 = u * u;
+	const tables& t = get();
+	double turns = (t.arctangent[k] + u * (1 - u2 * (1.0 / 3 - u2 * (1.0 / 5 - u2 * (1.0 / 7))))) * (1 / binary_angle<N>::two_pi);		// in [0, 1/8]
+	int octant = int(ay > ax) | int(x < 0) << 1 | int(y < 0) << 2;		// without branches, as the octant of a point is seldom predictable
+	return binary_angle<N>::from_turns(t.octant_offset[octant] + t.octant_sign[octant] * turns);
+}
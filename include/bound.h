@@ -1,67 +1,208 @@
 #pragma once
 
 /* To do
-		- remove all derived classes dependency on bound, so that you can remove the virtual 
-		keyord from the "void check()" function. (virtual slows things down a little and 
-		prevents compiler inlining).
-
 		- add no except where appropriate and possible
 
 		- consdier replacing min, val and max with an array of type T, so that swap can just swap the pointers to the start element and thus be more efficient.
 		note: this would likely increase look-up time of 2nd and 3rd elements, as it would require computing their position in the array.
 */
 
+#include <cassert>
+#include <exception>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "int_traits.h"
+#include "saturating.h"
+#include "wrap.h"
+
+// Bound policies
+//------------------------------------------------------------------------------------
+//		What a bound does with a value outside of [min, max], picked at compile time (so there is no virtual call, and check() inlines).
+//		Each provides check(val, min, max), and the arithmetic used by the operators: add, sub, mul and div.
+//		add and sub are also given the range, add(val, rhs, min, max), which only bound_wrap needs (to step round it without overflow).
+//
+//		bound_clamp		: move the value to the nearest limit (the default). Compiles to a branchless min and max.
+//		bound_wrap		: cycle the value round from max back to min (and from min to max), see cyclic.h and wrap.h.
+//						  Integers cycle through [min, max], floating point values through [min, max).
+//		bound_saturate	: clamp, and also saturate the arithmetic itself at the limits of T, so that an integer operation
+//						  that overflows clamps to the right limit instead of wrapping around first.
+//		bound_assert	: leave the value alone, and assert (in debug builds) that it is within the limits.
+//		bound_throw		: leave the value alone, and throw std::out_of_range if it is not within the limits.
+
+struct bound_arithmetic {
+	template <class T> static void add(T& val, const T& rhs) { val += rhs; }
+	template <class T> static void sub(T& val, const T& rhs) { val -= rhs; }
+	template <class T> static void add(T& val, const T& rhs, const T&, const T&) { val += rhs; }
+	template <class T> static void sub(T& val, const T& rhs, const T&, const T&) { val -= rhs; }
+	template <class T> static void mul(T& val, const T& rhs) { val *= rhs; }
+	template <class T> static void div(T& val, const T& rhs) { val /= rhs; }
+};
+
+struct bound_clamp : bound_arithmetic {
+	template <class T> static void check(T& val, const T& min, const T& max) noexcept(noexcept(val < min))
+	{
+		const T& low = val < min ? min : val;
+		val = max < low ? max : low;
+	}
+};
+
+struct bound_wrap : bound_arithmetic {
+	using bound_arithmetic::add;
+	using bound_arithmetic::sub;
+
+	// Integers step round the range from val, which is in it (see wrap_add in wrap.h), as adding first can overflow: 0u - 1 would wrap to the wrong value
+	template <class T> static void add(T& val, const T& rhs, const T& min, const T& max) { if constexpr (is_integer<T>::value) val = wrap_add(val, rhs, min, max); else val += rhs; }
+	template <class T> static void sub(T& val, const T& rhs, const T& min, const T& max) { if constexpr (is_integer<T>::value) val = wrap_add(val, rhs, min, max, true); else val -= rhs; }
+
+	template <class T> static void check(T& val, const T& min, const T& max)
+	{
+		if constexpr (std::is_arithmetic<T>::value || is_integer<T>::value) val = wrap(val, min, max);		// see wrap.h
+		else if (val > max) {
+			T range_plus_one = max - min + 1;
+			val -= int((val - min) / (range_plus_one)) * (range_plus_one);
+		}
+		else if (val < min) {
+			T range_plus_one = max - min + 1;
+			val += int((max - val) / (range_plus_one)) * (range_plus_one);
+		}
+	}
+
+	// Wrap an integer into the constant range [Min, Max], as used by static_cyclic. The differences are taken in
+	// unsigned arithmetic, so they cannot overflow, and the divisor is a constant, so the remainder compiles to a multiply
+	// (or, when the range is a power of two, a mask of the offset from Min, which wraps both ways without a branch).
+	template <class T, T Min, T Max> static void check(T& val) noexcept
+	{
+		typedef typename unsigned_of<T>::type U;
+		constexpr U size = U(U(Max) - U(Min) + 1);		// 0 if the range is all of T: nothing to wrap
+		if constexpr (size == 0) return;
+		else if constexpr ((size & (size - 1)) == 0) val = T(U(U(Min) + ((U(val) - U(Min)) & (size - 1))));
+		else if (val < Min) {
+			U below = U(U(Min) - U(val)) % size;
+			val = below == 0 ? Min : T(U(U(Min) + size - below));
+		}
+		else if (Max < val) val = T(U(U(Min) + U(U(val) - U(Min)) % size));
+	}
+};
+
+struct bound_saturate : bound_clamp {
+	template <class T> static void add(T& val, const T& rhs) { if constexpr (is_integer<T>::value) val = saturate_add(val, rhs); else val += rhs; }		// see saturating.h
+	template <class T> static void sub(T& val, const T& rhs) { if constexpr (is_integer<T>::value) val = saturate_sub(val, rhs); else val -= rhs; }
+	template <class T> static void mul(T& val, const T& rhs) { if constexpr (is_integer<T>::value) val = saturate_mul(val, rhs); else val *= rhs; }
+	template <class T> static void div(T& val, const T& rhs) { if constexpr (is_integer<T>::value) val = saturate_div(val, rhs); else val /= rhs; }
+	template <class T> static void add(T& val, const T& rhs, const T&, const T&) { add(val, rhs); }
+	template <class T> static void sub(T& val, const T& rhs, const T&, const T&) { sub(val, rhs); }
+};
+
+struct bound_assert : bound_arithmetic {
+	template <class T> static void check(T& val, const T& min, const T& max) noexcept { assert(!(val < min) && !(max < val)); (void)val; (void)min; (void)max; }
+};
+
+struct bound_throw : bound_arithmetic {
+	template <class T> static void check(T& val, const T& min, const T& max) { if (val < min || max < val) throw std::out_of_range("bound: value out of range"); }
+};
+
+/*	Deferred checking of one bound (or static_bound), so that a chain of operations is checked once, at the end:
+		{
+			auto d = b.defer();
+			d += x; d *= y; d -= z;		// no checks
+		}								// b is checked here (or by d.commit())
 
-#define MANUAL_CHECKING	0		// Turns the check function off, so the bound object's value is no longer bounded automatically. You can manually enforce bounds by calling check().
-								// This will allow you to chain-together lots of operations, and then check at the end (as opposed to check being called after each operation).
+	The operators act on the bound's value with the policy's arithmetic, and skip the check. Only the deferred bound is affected:
+	every other bound, of any type, is still checked after each operation. While the deferred is alive the value may be outside of
+	its limits, so change it only through the deferred. If the scope is left by an exception the check is skipped, so that
+	a bound_throw policy cannot throw from the destructor during unwinding. */
+template <class B>
+class deferred {
+	typedef typename B::value_type T;
+	typedef typename B::policy Policy;
 
-#if MANUAL_CHECKING
-	#define REM_CHECK(x)
-#else
-	#define REM_CHECK(x) x
-#endif
+	B* target;
+	int exceptions;		// uncaught exceptions when deferred, to tell a normal exit from unwinding
+
+	// bound_wrap steps an integer round the range from a value in it, so one left outside by *= or = is wrapped first
+	// (which is where the deferred check would put it anyway). Every other policy adds to the value as it is.
+	void in_range() { if constexpr (std::is_same<Policy, bound_wrap>::value && is_integer<T>::value) Policy::check(target->get(), target->get_min(), target->get_max()); }
+
+public:
+	explicit deferred(B& b) noexcept : target(&b), exceptions(std::uncaught_exceptions()) {}
+	deferred(deferred&& d) noexcept : target(d.target), exceptions(d.exceptions) { d.target = nullptr; }
+	deferred(const deferred&) = delete;
+	deferred& operator = (const deferred&) = delete;
+
+	~deferred() noexcept(false) { if (target && std::uncaught_exceptions() == exceptions) target->check(); }
+
+	void commit() { B* b = target; target = nullptr; if (b) b->check(); }		// check now, rather than at the end of the scope
+	void cancel() noexcept { target = nullptr; }								// leave the value unchecked
+
+	const T& get() const { return target->get(); }
+	operator T() const { return target->get(); }
+
+	// Operator overloads
+
+	deferred& operator  = (const T &rhs) { target->get() = rhs; return *this; }
+	deferred& operator += (const T &rhs) { in_range(); Policy::add(target->get(), rhs, target->get_min(), target->get_max()); return *this; }
+	deferred& operator -= (const T &rhs) { in_range(); Policy::sub(target->get(), rhs, target->get_min(), target->get_max()); return *this; }
+	deferred& operator *= (const T &rhs) { Policy::mul(target->get(), rhs); return *this; }
+	deferred& operator /= (const T &rhs) { Policy::div(target->get(), rhs); return *this; }
+
+	deferred& operator++() { return *this += T(1); }
+	deferred& operator--() { return *this -= T(1); }
+};
 
 /*	Represents a number bound between a minium and maximum:
 		min <= value <= max
 	All operators act exclusively on value (so bound += 5 is really value += 5). With the notable exception of = (assignment),
 	which sets all (value, min, max) to the assigned value. If only 1 value is provided for assignment, then it replaces value.
 
+		T		: the type of the value, and of its limits.
+		Policy	: what to do with values outside of the limits (see the bound policies above), clamp them by default.
+
+	There are no virtual functions, so a bound is exactly 3 * sizeof(T), and its checks inline into the operators.
+
 	Example use:
 		bound<double> b(5.0, 1.0, 10.0);
 		b += 10.0; // b = (1.0, 10.0, 10.0) Notice that value is capped at maximum (and is not 15.0 as it otherwise would be).
 		b == 10.0; // true (as value = 10.0)
 
+		bound<int, bound_throw> t(5, 1, 10);
+		t += 10;   // throws std::out_of_range
+
 	Can be used with any type that supports arithmetic and comparisons, e.g. bound<int>, bound<float>, bound<MyCustomType>. */
-template <class T>
+template <class T, class Policy = bound_clamp>
 class bound {
 protected:
 	T min, val, max;
 
+	// bound_wrap steps an integer round the range (see wrap_add), so the result is already in range: no check after += or -=.
+	static const bool in_range_steps = std::is_same<Policy, bound_wrap>::value && is_integer<T>::value;
+
 	friend void swap(bound& lhs, bound& rhs) noexcept(noexcept(T()))		// friend allows this to be a binary function (opposed to unary), and thus can be called instead of std::swap by STL containers
 	{
-		using std::swap;		
+		using std::swap;
 		swap(lhs.min, rhs.min);
 		swap(lhs.val, rhs.val);
 		swap(lhs.max, rhs.max);
 	}
 
 public:
+	typedef T value_type;
+	typedef Policy policy;
+
 	bound() noexcept(noexcept(T())) : min(), val(), max()  {}
-	bound(const T &val, const T &min, const T &max) noexcept(noexcept(T())) : min(min), val(val), max(max) { REM_CHECK(check()); }
-	bound(const bound<T>& b) noexcept(noexcept(T())) : min(b.min), val(b.val), max(b.max) {}
-	bound(bound<T>&& b) noexcept(noexcept(T())) : bound() { swap(*this, b); }	// alternatively: bound(bound&& b) noexcept : bound(std::move(b.val), std::move(b.min), std::move(b.max)) { }
-	
+	bound(const T &val, const T &min, const T &max) : min(min), val(val), max(max) { check(); }
+	bound(const bound& b) noexcept(noexcept(T())) : min(b.min), val(b.val), max(b.max) {}
+	bound(bound&& b) noexcept(noexcept(T())) : bound() { swap(*this, b); }	// alternatively: bound(bound&& b) noexcept : bound(std::move(b.val), std::move(b.min), std::move(b.max)) { }
+
 	~bound() {}
 
-	virtual void check()	// in order to offer no exceptions guarantee, need to guarantee > and < operators exist for type T.
-	{
-		if (val > max) { val = max; }
-		else if (val < min) { val = min; }
-	}
+	void check() { Policy::check(val, min, max); }
+	deferred<bound> defer() { return deferred<bound>(*this); }		// check once after a chain of operations, see deferred
 
 	std::ostream& print(std::ostream& os) const { os << min << " <= " << val << " <= " << max; return os; }
-	
+
 	T range() const { return max - min; }
 	T ratio() const { return (val - min) / range(); }
 
@@ -75,13 +216,13 @@ public:
 	const T& get_min() const { return min; }
 	const T& get_max() const { return max; }
 
-	void set    (const T &new_val) { val = new_val; REM_CHECK(check()); }
-	void set_min(const T &new_min) { min = new_min; REM_CHECK(check()); }
-	void set_max(const T &new_max) { max = new_max; REM_CHECK(check()); }
-	void set_all(const T &new_val, const T &new_min, const T &new_max) { val = new_val; min = new_min; max = new_max; REM_CHECK(check()); }
+	void set    (const T &new_val) { val = new_val; check(); }
+	void set_min(const T &new_min) { min = new_min; check(); }
+	void set_max(const T &new_max) { max = new_max; check(); }
+	void set_all(const T &new_val, const T &new_min, const T &new_max) { val = new_val; min = new_min; max = new_max; check(); }
+
+	// Type casts
 
-	// Type casts 
-	
 	int		to_int		() const { return (int		)val; }
 	long		to_long		() const { return (long		)val; }
 	float		to_float	() const { return (float	)val; }
@@ -91,19 +232,19 @@ public:
 
 	operator T() const { return val; }
 
-	// Operator overloads 
-	
-	bound& operator  = (T rhs) {std::swap(val,rhs); REM_CHECK(check()); return *this; }   // copy-swap idiom
-	bound& operator += (const T &rhs) { val += rhs; REM_CHECK(check()); return *this; }
-	bound& operator -= (const T &rhs) { val -= rhs; REM_CHECK(check()); return *this; }
-	bound& operator *= (const T &rhs) { val *= rhs; REM_CHECK(check()); return *this; }
-	bound& operator /= (const T &rhs) { val /= rhs; REM_CHECK(check()); return *this; }
+	// Operator overloads
+
+	bound& operator  = (T rhs) {std::swap(val,rhs); check(); return *this; }   // copy-swap idiom
+	bound& operator += (const T &rhs) { Policy::add(val, rhs, min, max); if constexpr (!in_range_steps) check(); return *this; }
+	bound& operator -= (const T &rhs) { Policy::sub(val, rhs, min, max); if constexpr (!in_range_steps) check(); return *this; }
+	bound& operator *= (const T &rhs) { Policy::mul(val, rhs); check(); return *this; }
+	bound& operator /= (const T &rhs) { Policy::div(val, rhs); check(); return *this; }
 
 	bound& operator  = (bound  rhs) noexcept(noexcept(T())) { swap(*this, rhs); return *this; } // copy-swap idiom
-	bound& operator += (const bound& rhs) { val += rhs.val; REM_CHECK(check()); return *this; }
-	bound& operator -= (const bound& rhs) { val -= rhs.val; REM_CHECK(check()); return *this; }
-	bound& operator *= (const bound& rhs) { val *= rhs.val; REM_CHECK(check()); return *this; }
-	bound& operator /= (const bound& rhs) { val /= rhs.val; REM_CHECK(check()); return *this; }
+	bound& operator += (const bound& rhs) { return *this += rhs.val; }
+	bound& operator -= (const bound& rhs) { return *this -= rhs.val; }
+	bound& operator *= (const bound& rhs) { return *this *= rhs.val; }
+	bound& operator /= (const bound& rhs) { return *this /= rhs.val; }
 
 	bool   operator == (const T &rhs) const { return     (val == rhs); }
 	bool   operator != (const T &rhs) const { return !operator==(rhs); }
@@ -120,11 +261,11 @@ public:
 	bool   operator >= (const bound& rhs) const { return !operator<(rhs); }
 
 	bound& operator++() {
-		++val; REM_CHECK(if (val > max) { val = max; });  // no need to check minium boundary
+		Policy::add(val, T(1), min, max); if constexpr (!in_range_steps) check();
 		return *this;
 	}
 	bound& operator--() {
-		--val; REM_CHECK(if (val < min) { val = min; });	// not necessary to check maximum boundary
+		Policy::sub(val, T(1), min, max); if constexpr (!in_range_steps) check();
 		return *this;
 	}
 	const bound operator++(int unused) {
@@ -139,28 +280,157 @@ public:
 	}
 };
 
-template <class T> bound<T> operator+ (bound<T> lhs, const T& rhs) { lhs += rhs; return lhs; }	// copies in lhs, adds to lhs, then returns lhs
-template <class T> bound<T> operator- (bound<T> lhs, const T& rhs) { lhs -= rhs; return lhs; }
-template <class T> bound<T> operator* (bound<T> lhs, const T& rhs) { lhs *= rhs; return lhs; }
-template <class T> bound<T> operator/ (bound<T> lhs, const T& rhs) { lhs /= rhs; return lhs; }
+template <class T, class P> bound<T, P> operator+ (bound<T, P> lhs, const T& rhs) { lhs += rhs; return lhs; }	// copies in lhs, adds to lhs, then returns lhs
+template <class T, class P> bound<T, P> operator- (bound<T, P> lhs, const T& rhs) { lhs -= rhs; return lhs; }
+template <class T, class P> bound<T, P> operator* (bound<T, P> lhs, const T& rhs) { lhs *= rhs; return lhs; }
+template <class T, class P> bound<T, P> operator/ (bound<T, P> lhs, const T& rhs) { lhs /= rhs; return lhs; }
 
-template <class T> bound<T> operator+ (const T& lhs, bound<T> rhs) { rhs += lhs; return rhs; }
-template <class T> bound<T> operator- (const T& lhs, bound<T> rhs) { rhs -= lhs; return rhs; }
-template <class T> bound<T> operator* (const T& lhs, bound<T> rhs) { rhs *= lhs; return rhs; }
-template <class T> bound<T> operator/ (const T& lhs, bound<T> rhs) { rhs /= lhs; return rhs; }
+template <class T, class P> bound<T, P> operator+ (const T& lhs, bound<T, P> rhs) { rhs += lhs; return rhs; }
+template <class T, class P> bound<T, P> operator- (const T& lhs, bound<T, P> rhs) { rhs -= lhs; return rhs; }
+template <class T, class P> bound<T, P> operator* (const T& lhs, bound<T, P> rhs) { rhs *= lhs; return rhs; }
+template <class T, class P> bound<T, P> operator/ (const T& lhs, bound<T, P> rhs) { rhs /= lhs; return rhs; }
 
-template <class T> bound<T> operator+ (bound<T> lhs, const bound<T> & rhs) { lhs += rhs; return lhs; }
-template <class T> bound<T> operator- (bound<T> lhs, const bound<T> & rhs) { lhs -= rhs; return lhs; }
-template <class T> bound<T> operator* (bound<T> lhs, const bound<T> & rhs) { lhs *= rhs; return lhs; }
-template <class T> bound<T> operator/ (bound<T> lhs, const bound<T> & rhs) { lhs /= rhs; return lhs; }
+template <class T, class P> bound<T, P> operator+ (bound<T, P> lhs, const bound<T, P> & rhs) { lhs += rhs; return lhs; }
+template <class T, class P> bound<T, P> operator- (bound<T, P> lhs, const bound<T, P> & rhs) { lhs -= rhs; return lhs; }
+template <class T, class P> bound<T, P> operator* (bound<T, P> lhs, const bound<T, P> & rhs) { lhs *= rhs; return lhs; }
+template <class T, class P> bound<T, P> operator/ (bound<T, P> lhs, const bound<T, P> & rhs) { lhs /= rhs; return lhs; }
+
+template <class T, class P> std::ostream& operator << (std::ostream& os, const bound<T, P>& a) { a.print(os); return os; }
+// Skip white space, then read the characters of delimiter, or set the stream's failbit
+inline std::istream& read_delimiter(std::istream& in, const char* delimiter)
+{
+	if (!(in >> std::ws)) return in;
+	for (; *delimiter; ++delimiter) if (in.get() != std::char_traits<char>::to_int_type(*delimiter)) { in.setstate(std::ios::failbit); break; }
+	return in;
+}
 
-template <class T> std::ostream& operator << (std::ostream& os, const bound<T>& a) { a.print(os); return os; }
-template <class T> std::istream& operator >> (std::istream& in, bound<T>& b) {
+// Reads what operator << writes, "min <= val <= max", or the older "val, min, max" (with any white space).
+// The bound is only changed once all three numbers are read, so on bad input it is unchanged and the stream's failbit is set.
+template <class T, class P> std::istream& operator >> (std::istream& in, bound<T, P>& b) {
 	T x, y, z;
-	in >> x; b.set(x);	// read val		:, min, max
-	in.ignore(2);		// skip delimiter	:min, max
-	in >> y; b.set_min(y);	// read minimum		:, max
-	in.ignore(2);		// skip delimiter	:max
-	in >> z; b.set_max(z);	// read maximum
+	if (!(in >> x >> std::ws)) return in;
+	if (in.peek() == '<') {
+		if (read_delimiter(in, "<=") >> y && read_delimiter(in, "<=") >> z) b.set_all(y, x, z);		// x <= y <= z
+	}
+	else if (read_delimiter(in, ",") >> y && read_delimiter(in, ",") >> z) b.set_all(x, y, z);		// x, y, z
 	return in;
 }
+
+/*	A bound whose limits are constants: template parameters rather than members, so the object is a single T,
+	and the checks compare against (and wrap by) constants that the compiler folds into the code.
+		static_bound<int, 0, 100> percent(50);
+		percent += 80;		// 100
+		static_cyclic<unsigned, 0, 1023> index;		// wraps with a mask, see cyclic.h
+
+	The limits must be integers (or, from C++20, any type allowed as a template parameter, e.g. double).
+	Supports the same policies, accessors and operators as bound, except those that change the limits. */
+template <class T, T Min, T Max, class Policy = bound_clamp>
+class static_bound {
+	static_assert(!(Max < Min), "static_bound requires Min <= Max");
+
+protected:
+	T val;
+
+	// With the limits of T as its limits, a saturating bound is a saturating<T> (see saturating.h): it needs no check.
+	static const bool saturating_backend = std::is_same<Policy, bound_saturate>::value && is_integer<T>::value && Min == int_limits<T>::min() && Max == int_limits<T>::max();
+
+	// += and -= of a static_cyclic of integers. A power of two range is a plain add modulo 2^N, which the mask in check() wraps
+	// (a single add and mask). Any other range steps round with wrap_add, which leaves the value in range, so needs no check.
+	void step(const T &rhs, bool negate)
+	{
+		if constexpr (std::is_same<Policy, bound_wrap>::value && is_integer<T>::value) {
+			typedef typename unsigned_of<T>::type U;
+			constexpr U size = U(U(Max) - U(Min) + 1);
+			if constexpr ((size & U(size - 1)) == 0) { val = T(negate ? U(U(val) - U(rhs)) : U(U(val) + U(rhs))); check(); }
+			else val = wrap_add(val, rhs, Min, Max, negate);
+		}
+		else {
+			if (negate) Policy::sub(val, rhs, Min, Max); else Policy::add(val, rhs, Min, Max);
+			check();
+		}
+	}
+
+public:
+	typedef T value_type;
+	typedef Policy policy;
+
+	static_bound() noexcept(noexcept(T())) : val(Min) {}
+	static_bound(const T &val) : val(val) { check(); }
+
+	void check()
+	{
+		if constexpr (std::is_same<Policy, bound_wrap>::value && is_integer<T>::value) bound_wrap::check<T, Min, Max>(val);
+		else if constexpr (saturating_backend) {}		// the arithmetic already stopped at the limits
+		else Policy::check(val, Min, Max);
+	}
+	deferred<static_bound> defer() { return deferred<static_bound>(*this); }
+
+	std::ostream& print(std::ostream& os) const { os << Min << " <= " << val << " <= " << Max; return os; }
+
+	static constexpr T range() { return Max - Min; }
+	T ratio() const { return (val - Min) / range(); }
+
+	// Accessors
+
+	T& get() noexcept { return val; }
+	const T& get() const noexcept { return val; }
+	static constexpr T get_min() noexcept { return Min; }
+	static constexpr T get_max() noexcept { return Max; }
+
+	void set(const T &new_val) { val = new_val; check(); }
+
+	// Type casts
+
+	int		to_int		() const { return (int		)val; }
+	long		to_long		() const { return (long		)val; }
+	float		to_float	() const { return (float	)val; }
+	double		to_double	() const { return (double	)val; }
+	long long	to_long_long	() const { return (long long	)val; }
+	std::string to_string   	() const { return std::to_string(val); }
+
+	operator T() const { return val; }
+
+	// Operator overloads
+
+	static_bound& operator  = (const T &rhs) { val = rhs; check(); return *this; }
+	static_bound& operator += (const T &rhs) { step(rhs, false); return *this; }
+	static_bound& operator -= (const T &rhs) { step(rhs, true); return *this; }
+	static_bound& operator *= (const T &rhs) { Policy::mul(val, rhs); check(); return *this; }
+	static_bound& operator /= (const T &rhs) { Policy::div(val, rhs); check(); return *this; }
+
+	static_bound& operator += (const static_bound& rhs) { return *this += rhs.val; }
+	static_bound& operator -= (const static_bound& rhs) { return *this -= rhs.val; }
+	static_bound& operator *= (const static_bound& rhs) { return *this *= rhs.val; }
+	static_bound& operator /= (const static_bound& rhs) { return *this /= rhs.val; }
+
+	bool   operator == (const T &rhs) const { return     (val == rhs); }
+	bool   operator != (const T &rhs) const { return !operator==(rhs); }
+	bool   operator <  (const T &rhs) const { return       val < rhs ; }
+	bool   operator >  (const T &rhs) const { return       val > rhs ; }
+	bool   operator <= (const T &rhs) const { return !operator >(rhs); }
+	bool   operator >= (const T &rhs) const { return !operator <(rhs); }
+
+	bool   operator == (const static_bound& rhs) const { return val == rhs.val; }
+	bool   operator != (const static_bound& rhs) const { return !operator==(rhs); }
+	bool   operator <  (const static_bound& rhs) const { return val < rhs.val; }
+	bool   operator >  (const static_bound& rhs) const { return val > rhs.val; }
+	bool   operator <= (const static_bound& rhs) const { return !operator>(rhs); }
+	bool   operator >= (const static_bound& rhs) const { return !operator<(rhs); }
+
+	static_bound& operator++() { return *this += T(1); }
+	static_bound& operator--() { return *this -= T(1); }
+	const static_bound operator++(int unused) { static_bound result(*this); ++(*this); return result; }
+	const static_bound operator--(int unused) { static_bound result(*this); --(*this); return result; }
+};
+
+template <class T, T Min, T Max, class P> static_bound<T, Min, Max, P> operator+ (static_bound<T, Min, Max, P> lhs, const T& rhs) { lhs += rhs; return lhs; }
+template <class T, T Min, T Max, class P> static_bound<T, Min, Max, P> operator- (static_bound<T, Min, Max, P> lhs, const T& rhs) { lhs -= rhs; return lhs; }
+template <class T, T Min, T Max, class P> static_bound<T, Min, Max, P> operator* (static_bound<T, Min, Max, P> lhs, const T& rhs) { lhs *= rhs; return lhs; }
+template <class T, T Min, T Max, class P> static_bound<T, Min, Max, P> operator/ (static_bound<T, Min, Max, P> lhs, const T& rhs) { lhs /= rhs; return lhs; }
+
+template <class T, T Min, T Max, class P> static_bound<T, Min, Max, P> operator+ (static_bound<T, Min, Max, P> lhs, const static_bound<T, Min, Max, P>& rhs) { lhs += rhs; return lhs; }
+template <class T, T Min, T Max, class P> static_bound<T, Min, Max, P> operator- (static_bound<T, Min, Max, P> lhs, const static_bound<T, Min, Max, P>& rhs) { lhs -= rhs; return lhs; }
+template <class T, T Min, T Max, class P> static_bound<T, Min, Max, P> operator* (static_bound<T, Min, Max, P> lhs, const static_bound<T, Min, Max, P>& rhs) { lhs *= rhs; return lhs; }
+template <class T, T Min, T Max, class P> static_bound<T, Min, Max, P> operator/ (static_bound<T, Min, Max, P> lhs, const static_bound<T, Min, Max, P>& rhs) { lhs /= rhs; return lhs; }
+
+template <class T, T Min, T Max, class P> std::ostream& operator << (std::ostream& os, const static_bound<T, Min, Max, P>& a) { a.print(os); return os; }
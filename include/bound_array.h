@@ -0,0 +1,211 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "bound.h"
+#include "simd.h"
+#include "wrap.h"
+
+// Batch kernels for bound and cyclic arrays
+//		Each applies an elementwise operation (values[i] op rhs[i], or values[i] op scalar if rhs is null),
+//		then clamps (as bound_clamp) or wraps (as wrap.h) the result into [min, max], giving exactly the same result
+//		as the scalar bound and cyclic. op_check only clamps or wraps. Integer arithmetic wraps round on overflow.
+//
+//		Provided for float, double and int. get() returns the kernels for the best instruction set of this CPU
+//		(see simd.h), or those for a given instruction set. Implementation in bound_array.cpp.
+//------------------------------------------------------------------------------------
+
+enum bound_op { op_check, op_add, op_sub, op_mul, op_div };
+
+template <class T>
+struct bound_kernels
+{
+	typedef void (*shared_op)(T* values, const T* rhs, T scalar, bound_op op, T min, T max, std::size_t n);
+	typedef void (*lanes_op)(T* values, const T* rhs, T scalar, bound_op op, const T* mins, const T* maxs, std::size_t n);
+
+	shared_op clamp;			// one range for every value
+	lanes_op  clamp_lanes;		// a range per value
+	shared_op wrap;
+
+	static const bound_kernels& get(simd_isa isa = active_isa());
+};
+
+template <> const bound_kernels<float>&  bound_kernels<float>::get(simd_isa isa);
+template <> const bound_kernels<double>& bound_kernels<double>::get(simd_isa isa);
+template <> const bound_kernels<int>&    bound_kernels<int>::get(simd_isa isa);
+
+//	An array of bound values, stored contiguously, with either one range shared by every value or a range per value (lane).
+//		T		: the type of the values.
+//		Policy	: as for bound. bound_clamp (bound_array) and bound_wrap (cyclic_array) of float, double and int use the
+//				  vectorised kernels above (AVX2 or AVX-512 where available); anything else is a loop over the policy.
+//
+//	A third of the memory of a vector of bound<T>, as the range is not repeated for every value (unless it differs per value).
+//	The batch operators act elementwise, then check every value. An array operand must be the same size (or std::length_error is thrown).
+//
+//	Example use:
+//		bound_array<float> readings(1000, 0.0f, -40.0f, 125.0f);		// 1000 sensor values in [-40, 125]
+//		readings.assign(raw, 1000);										// clamped as they are stored
+//		readings *= 1.8f; readings += 32.0f;							// each a single pass
+//		cyclic_array<double> phases(64, 0.0, 0.0, 2 * pi);
+//		phases += increments;											// wrapped into [0, 2 pi)
+template <class T, class Policy = bound_clamp>
+class bound_array
+{
+public:
+	typedef T value_type;
+	typedef Policy policy;
+	typedef std::vector<T, aligned_allocator<T> > storage;
+
+private:
+	storage values;
+	storage mins, maxs;		// the range of each value, or empty if they share min and max
+	T min, max;
+
+	static const bool kernel_type = std::is_same<T, float>::value || std::is_same<T, double>::value || std::is_same<T, int>::value;
+	static const bool clamp_kernels = kernel_type && std::is_same<Policy, bound_clamp>::value;
+	static const bool wrap_kernels  = kernel_type && std::is_same<Policy, bound_wrap>::value;
+
+	void check_size(std::size_t n) const { if (n != size()) throw std::length_error("bound_array sizes differ"); }
+	static void apply_op(T& val, const T& rhs, bound_op op, const T& min, const T& max);
+	void apply(const T* rhs, T scalar, bound_op op);
+
+public:
+
+	// Construction
+
+	bound_array() : min(), max() {}
+	bound_array(std::size_t n, const T& value, const T& min, const T& max) : values(n, value), min(min), max(max) { check(); }
+	bound_array(storage values, const T& min, const T& max) : values(std::move(values)), min(min), max(max) { check(); }		// takes the values, without copying
+	bound_array(storage values, storage mins, storage maxs) : values(std::move(values)), mins(std::move(mins)), maxs(std::move(maxs)), min(), max()		// and a range per value
+	{
+		check_size(this->mins.size()); check_size(this->maxs.size());
+		check();
+	}
+
+	// Accessors
+
+	std::size_t size() const noexcept { return values.size(); }
+	bool empty() const noexcept { return values.empty(); }
+	bool shared_range() const noexcept { return mins.empty(); }
+	void reserve(std::size_t n) { values.reserve(n); if (!shared_range()) { mins.reserve(n); maxs.reserve(n); } }
+	void clear() noexcept { values.clear(); mins.clear(); maxs.clear(); }
+
+	void push_back(const T& value) { push_back(value, min, max); }
+	void push_back(const T& value, const T& lane_min, const T& lane_max);
+
+	T get(std::size_t i) const { return values[i]; }
+	void set(std::size_t i, const T& value) { values[i] = value; Policy::check(values[i], get_min(i), get_max(i)); }
+	T operator [] (std::size_t i) const { return values[i]; }
+
+	const T& get_min(std::size_t i) const { return shared_range() ? min : mins[i]; }
+	const T& get_max(std::size_t i) const { return shared_range() ? max : maxs[i]; }
+	bound<T, Policy> get_bound(std::size_t i) const { return bound<T, Policy>(values[i], get_min(i), get_max(i)); }
+
+	void set_range(const T& new_min, const T& new_max) { mins.clear(); maxs.clear(); min = new_min; max = new_max; check(); }		// shared by every value
+	void set_ranges(const T* new_mins, const T* new_maxs);		// one per value
+
+	      T* data() noexcept { return values.data(); }		// aligned to simd_alignment. Call check() after writing through it.
+	const T* data() const noexcept { return values.data(); }
+
+	// Batch functions
+
+	void check() { apply(nullptr, T(), op_check); }
+	void assign(const T* source, std::size_t n);		// keeps the ranges: with a range per value, n must not be more than size() (or std::length_error is thrown)
+	void assign(const T* source, std::size_t n, const T& lane_min, const T& lane_max);		// values past size() are given [lane_min, lane_max]
+
+	// Batch operator overloads
+
+	bound_array& operator += (const T& rhs) { apply(nullptr, rhs, op_add); return *this; }
+	bound_array& operator -= (const T& rhs) { apply(nullptr, rhs, op_sub); return *this; }
+	bound_array& operator *= (const T& rhs) { apply(nullptr, rhs, op_mul); return *this; }
+	bound_array& operator /= (const T& rhs) { apply(nullptr, rhs, op_div); return *this; }
+
+	template <class A> bound_array& operator += (const std::vector<T, A>& rhs) { check_size(rhs.size()); apply(rhs.data(), T(), op_add); return *this; }
+	template <class A> bound_array& operator -= (const std::vector<T, A>& rhs) { check_size(rhs.size()); apply(rhs.data(), T(), op_sub); return *this; }
+	template <class A> bound_array& operator *= (const std::vector<T, A>& rhs) { check_size(rhs.size()); apply(rhs.data(), T(), op_mul); return *this; }
+	template <class A> bound_array& operator /= (const std::vector<T, A>& rhs) { check_size(rhs.size()); apply(rhs.data(), T(), op_div); return *this; }
+
+	bound_array& operator += (const bound_array& rhs) { check_size(rhs.size()); apply(rhs.data(), T(), op_add); return *this; }
+	bound_array& operator -= (const bound_array& rhs) { check_size(rhs.size()); apply(rhs.data(), T(), op_sub); return *this; }
+	bound_array& operator *= (const bound_array& rhs) { check_size(rhs.size()); apply(rhs.data(), T(), op_mul); return *this; }
+	bound_array& operator /= (const bound_array& rhs) { check_size(rhs.size()); apply(rhs.data(), T(), op_div); return *this; }
+};
+
+template <class T>
+using cyclic_array = bound_array<T, bound_wrap>;
+
+// Accessors
+
+template <class T, class P> void bound_array<T, P>::push_back(const T& value, const T& lane_min, const T& lane_max)
+{
+	if (shared_range() && (lane_min != min || lane_max != max)) {
+		// The first value with a range of its own: give every value its own range.
+		mins.assign(size(), min);
+		maxs.assign(size(), max);
+	}
+	values.push_back(value);
+	if (!shared_range() || lane_min != min || lane_max != max) { mins.push_back(lane_min); maxs.push_back(lane_max); }
+	P::check(values.back(), lane_min, lane_max);
+}
+
+template <class T, class P> void bound_array<T, P>::set_ranges(const T* new_mins, const T* new_maxs)
+{
+	mins.assign(new_mins, new_mins + size());
+	maxs.assign(new_maxs, new_maxs + size());
+	check();
+}
+
+// Batch functions
+
+template <class T, class P> void bound_array<T, P>::assign(const T* source, std::size_t n)
+{
+	if (!shared_range()) {
+		if (n > size()) throw std::length_error("bound_array: assign needs a range for the new values");
+		mins.resize(n); maxs.resize(n);
+	}
+	values.assign(source, source + n);
+	check();
+}
+
+template <class T, class P> void bound_array<T, P>::assign(const T* source, std::size_t n, const T& lane_min, const T& lane_max)
+{
+	if (shared_range() && n > size() && (lane_min != min || lane_max != max)) {
+		// The new values have a range of their own: give every value its own range, as push_back does.
+		mins.assign(size(), min);
+		maxs.assign(size(), max);
+	}
+	if (!shared_range()) { mins.resize(n, lane_min); maxs.resize(n, lane_max); }
+	values.assign(source, source + n);
+	check();
+}
+
+template <class T, class P> void bound_array<T, P>::apply_op(T& val, const T& rhs, bound_op op, const T& min, const T& max)
+{
+	switch (op) {
+	case op_check: break;
+	case op_add: P::add(val, rhs, min, max); break;
+	case op_sub: P::sub(val, rhs, min, max); break;
+	case op_mul: P::mul(val, rhs); break;
+	case op_div: P::div(val, rhs); break;
+	}
+}
+
+template <class T, class P> void bound_array<T, P>::apply(const T* rhs, T scalar, bound_op op)
+{
+	if constexpr (clamp_kernels || wrap_kernels) {
+		const bound_kernels<T>& kernels = bound_kernels<T>::get();
+		if (shared_range()) {
+			if constexpr (clamp_kernels) kernels.clamp(values.data(), rhs, scalar, op, min, max, size());
+			else kernels.wrap(values.data(), rhs, scalar, op, min, max, size());
+			return;
+		}
+		if constexpr (clamp_kernels) { kernels.clamp_lanes(values.data(), rhs, scalar, op, mins.data(), maxs.data(), size()); return; }
+	}
+	for (std::size_t i = 0; i < size(); ++i) {
+		apply_op(values[i], rhs ? rhs[i] : scalar, op, get_min(i), get_max(i));
+		P::check(values[i], get_min(i), get_max(i));
+	}
+}
@@ -0,0 +1,312 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "bound.h"
+#include "bound_array.h"
+
+/*	Binary files of bound and cyclic values, for large parameter tables, and a read-only view of such a file mapped into memory.
+
+		write_binary(os, array)		: writes a bound_array or cyclic_array (or a std::vector of bound) as below.
+		read_binary(is, array)		: reads one back into a bound_array or cyclic_array, checking every value with the array's policy.
+		bound_view<T, Policy>		: the values and ranges of a file, mapped into memory (mmap, or MapViewOfFile on Windows) and used in place,
+									  so opening a table of any size is a few system calls: pages are read from disk as they are first used.
+		mapped_file					: the read-only memory mapping under bound_view. Implementation in bound_io.cpp.
+
+	The file is a 64 byte header, then the values, then either the shared min and max or a min and a max per value:
+
+		offset	size	field
+		0		8		magic, "BOUNDARR"
+		8		4		0x01020304, in the byte order of the machine that wrote the file
+		12		2		version (bound_file_version)
+		14		1		the type of the values (bound_file_type<T>)
+		15		1		flags: bound_file_lanes if each value has its own range, bound_file_cyclic if written from a cyclic (wrap) array
+		16		8		count, the number of values
+		24		24		the offsets of the values, the mins and the maxs from the start of the file (one min and one max if they are shared)
+		48		16		reserved, 0
+
+	Each array starts on a multiple of 64 bytes (simd_alignment), so a mapped view is aligned for the batch kernels. The numbers are in
+	the byte order of the writer: a file from a machine of the other order is refused. A newer version may add fields to the header,
+	so the arrays are found by their offsets, never by position, and files of older versions stay readable.
+
+	Errors in reading (a bad header, a different value type, or a truncated file) throw std::runtime_error.
+	Writing leaves any error in the stream's state, as operator << does.
+
+	Example use:
+		std::ofstream out("gains.bin", std::ios::binary);
+		write_binary(out, gains);						// a bound_array<float> of 100M values
+		...
+		bound_view<float> table("gains.bin");			// no reading or parsing
+		float g = table[12345678];
+*/
+
+const std::uint16_t bound_file_version = 1;
+
+enum bound_file_flags : std::uint8_t { bound_file_lanes = 1, bound_file_cyclic = 2 };
+
+struct bound_file_header
+{
+	char magic[8];
+	std::uint32_t byte_order;
+	std::uint16_t version;
+	std::uint8_t type;
+	std::uint8_t flags;
+	std::uint64_t count;
+	std::uint64_t values, mins, maxs;
+	std::uint64_t reserved[2];
+};
+
+static_assert(sizeof(bound_file_header) == 64, "bound_file_header must be 64 bytes");
+
+// The type code of the values: 1 to 8 for int8_t, uint8_t, ... uint64_t, 9 for float and 10 for double
+template <class T> constexpr std::uint8_t bound_file_type() noexcept
+{
+	static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value && !std::is_same<T, long double>::value,
+		"bound files hold integers, float or double");
+	if constexpr (std::is_floating_point<T>::value) return sizeof(T) == 4 ? 9 : 10;
+	else return std::uint8_t((sizeof(T) == 1 ? 1 : sizeof(T) == 2 ? 3 : sizeof(T) == 4 ? 5 : 7) + (std::is_unsigned<T>::value ? 1 : 0));
+}
+
+// A header for count values of type T, with the arrays laid out one after another
+bound_file_header make_bound_header(std::uint8_t type, std::size_t value_size, std::uint64_t count, std::uint8_t flags);
+
+// Throws std::runtime_error if the header is not that of a file of type, of at most file_size bytes (if given)
+void check_bound_header(const bound_file_header& header, std::uint8_t type, std::size_t value_size, std::uint64_t file_size = ~std::uint64_t(0));
+
+// Writing
+//------------------------------------------------------------------------------------
+
+namespace bound_io {
+	// Write zeros, to move from offset at to offset to
+	inline void pad(std::ostream& os, std::uint64_t at, std::uint64_t to)
+	{
+		static const char zeros[64] = {};
+		for (; at < to; at += 64) os.write(zeros, std::streamsize(to - at < 64 ? to - at : 64));
+	}
+
+	// Write count values, taken from get(i) a block at a time
+	template <class T, class Get> void write_column(std::ostream& os, std::size_t count, Get get)
+	{
+		T block[1024];
+		for (std::size_t i = 0; i < count; ) {
+			std::size_t n = 0;
+			for (; n < 1024 && i < count; ++n, ++i) block[n] = get(i);
+			os.write(reinterpret_cast<const char*>(block), std::streamsize(n * sizeof(T)));
+		}
+	}
+}
+
+template <class T, class P> void write_binary(std::ostream& os, const bound_array<T, P>& a)
+{
+	std::uint8_t flags = std::uint8_t((a.shared_range() ? 0 : bound_file_lanes) | (std::is_same<P, bound_wrap>::value ? bound_file_cyclic : 0));
+	bound_file_header header = make_bound_header(bound_file_type<T>(), sizeof(T), a.size(), flags);
+	os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	bound_io::pad(os, sizeof(header), header.values);
+	os.write(reinterpret_cast<const char*>(a.data()), std::streamsize(a.size() * sizeof(T)));
+	bound_io::pad(os, header.values + a.size() * sizeof(T), header.mins);
+	if (a.shared_range()) {
+		T min = a.empty() ? T() : a.get_min(0), max = a.empty() ? T() : a.get_max(0);
+		os.write(reinterpret_cast<const char*>(&min), sizeof(T));
+		bound_io::pad(os, header.mins + sizeof(T), header.maxs);
+		os.write(reinterpret_cast<const char*>(&max), sizeof(T));
+		return;
+	}
+	bound_io::write_column<T>(os, a.size(), [&](std::size_t i) { return a.get_min(i); });
+	bound_io::pad(os, header.mins + a.size() * sizeof(T), header.maxs);
+	bound_io::write_column<T>(os, a.size(), [&](std::size_t i) { return a.get_max(i); });
+}
+
+// A std::vector of bound, with a shared range if every value has the same one
+template <class T, class P, class A> void write_binary(std::ostream& os, const std::vector<bound<T, P>, A>& v)
+{
+	bool shared = true;
+	for (std::size_t i = 1; i < v.size() && shared; ++i) shared = v[i].get_min() == v[0].get_min() && v[i].get_max() == v[0].get_max();
+
+	std::uint8_t flags = std::uint8_t((shared ? 0 : bound_file_lanes) | (std::is_same<P, bound_wrap>::value ? bound_file_cyclic : 0));
+	bound_file_header header = make_bound_header(bound_file_type<T>(), sizeof(T), v.size(), flags);
+	os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	bound_io::pad(os, sizeof(header), header.values);
+	bound_io::write_column<T>(os, v.size(), [&](std::size_t i) { return v[i].get(); });
+	bound_io::pad(os, header.values + v.size() * sizeof(T), header.mins);
+	std::size_t n = shared ? (v.empty() ? 0 : 1) : v.size();
+	bound_io::write_column<T>(os, n, [&](std::size_t i) { return v[i].get_min(); });
+	if (n == 0) bound_io::write_column<T>(os, 1, [](std::size_t) { return T(); });
+	bound_io::pad(os, header.mins + (shared ? 1 : n) * sizeof(T), header.maxs);
+	bound_io::write_column<T>(os, n, [&](std::size_t i) { return v[i].get_max(); });
+	if (n == 0) bound_io::write_column<T>(os, 1, [](std::size_t) { return T(); });
+}
+
+// Reading
+//------------------------------------------------------------------------------------
+
+namespace bound_io {
+	// Read count values into data, after skipping from offset at to offset to
+	template <class T> void read_column(std::istream& is, std::uint64_t& at, std::uint64_t to, T* data, std::size_t count)
+	{
+		is.ignore(std::streamsize(to - at));
+		is.read(reinterpret_cast<char*>(data), std::streamsize(count * sizeof(T)));
+		if (!is) throw std::runtime_error("bound file: truncated");
+		at = to + count * sizeof(T);
+	}
+
+	// Read count values into data, a chunk at a time, so a corrupt count fails on the end of the stream rather than on allocation
+	template <class T, class A> void read_column(std::istream& is, std::uint64_t& at, std::uint64_t to, std::vector<T, A>& data, std::size_t count, bool reserve)
+	{
+		const std::size_t chunk = (std::size_t(1) << 20) / sizeof(T);
+		data.clear();
+		if (reserve) data.reserve(count);
+		is.ignore(std::streamsize(to - at));
+		for (std::size_t done = 0; done < count; ) {
+			std::size_t k = count - done < chunk ? count - done : chunk;
+			data.resize(done + k);
+			is.read(reinterpret_cast<char*>(data.data() + done), std::streamsize(k * sizeof(T)));
+			if (!is) throw std::runtime_error("bound file: truncated");
+			done += k;
+		}
+		at = to + count * sizeof(T);
+	}
+
+	// The bytes from the start of the header (consumed bytes back) to the end of the stream, or ~0 if the stream cannot seek
+	inline std::uint64_t stream_size(std::istream& is, std::uint64_t consumed)
+	{
+		std::istream::pos_type at = is.tellg();
+		if (at == std::istream::pos_type(-1)) return ~std::uint64_t(0);
+		if (!is.seekg(0, std::ios::end)) { is.clear(); return ~std::uint64_t(0); }
+		std::istream::pos_type end = is.tellg();
+		if (!is.seekg(at)) throw std::runtime_error("bound file: cannot seek back in the stream");
+		if (end == std::istream::pos_type(-1) || end < at) return ~std::uint64_t(0);
+		return consumed + std::uint64_t(end - at);
+	}
+}
+
+template <class T, class P> void read_binary(std::istream& is, bound_array<T, P>& a)
+{
+	typedef typename bound_array<T, P>::storage storage;
+
+	bound_file_header header;
+	if (!is.read(reinterpret_cast<char*>(&header), sizeof(header))) throw std::runtime_error("bound file: truncated header");
+	// If the stream can seek, the count is checked against what is left of it before anything is allocated; if not, the arrays grow as they are read
+	std::uint64_t size = bound_io::stream_size(is, sizeof(header));
+	check_bound_header(header, bound_file_type<T>(), sizeof(T), size);
+	bool known = size != ~std::uint64_t(0);
+
+	std::size_t n = std::size_t(header.count);
+	std::uint64_t at = sizeof(header);
+	storage values;
+	bound_io::read_column(is, at, header.values, values, n, known);
+	if (header.flags & bound_file_lanes) {
+		storage mins, maxs;
+		bound_io::read_column(is, at, header.mins, mins, n, known);
+		bound_io::read_column(is, at, header.maxs, maxs, n, known);
+		a = bound_array<T, P>(std::move(values), std::move(mins), std::move(maxs));
+	}
+	else {
+		T min, max;
+		bound_io::read_column(is, at, header.mins, &min, 1);
+		bound_io::read_column(is, at, header.maxs, &max, 1);
+		a = bound_array<T, P>(std::move(values), min, max);
+	}
+}
+
+// Memory mapped files
+//------------------------------------------------------------------------------------
+
+//	A whole file, mapped read-only into memory. Throws std::runtime_error if it cannot be opened or mapped.
+//	Movable, not copyable; the mapping is removed by the destructor.
+class mapped_file
+{
+	const void* address;
+	std::size_t length;
+#ifdef _WIN32
+	void* mapping;			// the HANDLE of the file mapping object
+#endif
+
+	void release() noexcept;
+
+public:
+	mapped_file() noexcept;
+	explicit mapped_file(const std::string& path);
+	mapped_file(mapped_file&& rhs) noexcept;
+	mapped_file& operator = (mapped_file&& rhs) noexcept;
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator = (const mapped_file&) = delete;
+	~mapped_file() { release(); }
+
+	const void* data() const noexcept { return address; }		// aligned to a page
+	std::size_t size() const noexcept { return length; }
+};
+
+//	The contents of a bound file, in place: in a file mapped by the view, or in memory owned by the caller (which must outlive the view).
+//	The values are not checked, as they were when written: a file written by other means should be checked with valid().
+//	to_array() copies the view into a bound_array that can be modified.
+template <class T, class Policy = bound_clamp>
+class bound_view
+{
+	mapped_file file;
+	const T* values;
+	const T* mins;
+	const T* maxs;
+	std::size_t count;
+	bool lanes, wrapped;
+
+	void open(const void* data, std::size_t size)
+	{
+		if (size < sizeof(bound_file_header)) throw std::runtime_error("bound file: truncated header");
+		if (reinterpret_cast<std::uintptr_t>(data) % alignof(bound_file_header) != 0) throw std::runtime_error("bound file: misaligned in memory");
+		const bound_file_header& header = *static_cast<const bound_file_header*>(data);
+		check_bound_header(header, bound_file_type<T>(), sizeof(T), size);
+		const char* base = static_cast<const char*>(data);
+		values = reinterpret_cast<const T*>(base + header.values);
+		mins = reinterpret_cast<const T*>(base + header.mins);
+		maxs = reinterpret_cast<const T*>(base + header.maxs);
+		count = std::size_t(header.count);
+		lanes = (header.flags & bound_file_lanes) != 0;
+		wrapped = (header.flags & bound_file_cyclic) != 0;
+	}
+
+public:
+	typedef T value_type;
+	typedef Policy policy;
+
+	explicit bound_view(const std::string& path) : file(path) { open(file.data(), file.size()); }		// maps the file
+	bound_view(const void* data, std::size_t size) { open(data, size); }		// data must be aligned to 8 bytes
+
+	// Accessors
+
+	std::size_t size() const noexcept { return count; }
+	bool empty() const noexcept { return count == 0; }
+	bool shared_range() const noexcept { return !lanes; }
+	bool cyclic() const noexcept { return wrapped; }		// written from a cyclic (wrap) array
+
+	T get(std::size_t i) const { return values[i]; }
+	T operator [] (std::size_t i) const { return values[i]; }
+	const T& get_min(std::size_t i) const { return lanes ? mins[i] : *mins; }
+	const T& get_max(std::size_t i) const { return lanes ? maxs[i] : *maxs; }
+	bound<T, Policy> get_bound(std::size_t i) const { return bound<T, Policy>(values[i], get_min(i), get_max(i)); }
+
+	const T* data() const noexcept { return values; }		// size() values
+	const T* min_data() const noexcept { return mins; }		// size() mins, or one if shared_range()
+	const T* max_data() const noexcept { return maxs; }
+
+	// Functions
+
+	bool valid() const		// every value is within its range
+	{
+		for (std::size_t i = 0; i < count; ++i) if (values[i] < get_min(i) || values[i] > get_max(i)) return false;
+		return true;
+	}
+
+	bound_array<T, Policy> to_array() const
+	{
+		typedef typename bound_array<T, Policy>::storage storage;
+		storage copy(values, values + count);
+		if (!lanes) return bound_array<T, Policy>(std::move(copy), *mins, *maxs);
+		return bound_array<T, Policy>(std::move(copy), storage(mins, mins + count), storage(maxs, maxs + count));
+	}
+};
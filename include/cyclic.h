@@ -2,36 +2,26 @@
 
 #include "bound.h"
 
-/*	Derives from bound<T>, but instead of being capped between a min and max it cycles between them.
-E.g.	Cyclic<double> c(0.0, 1.0, 3.0);
-		c += 1;		// (0.0, 2.0, 3.0)
-		c += 1;		// (0.0, 3.0, 3.0)
-		c += 1;		// (0.0, 0.0, 3.0)	<-- returns back to min
-		c += 1;		// (0.0, 1.0, 3.0)  Repeats the cycle.
+/*	A bound<T> that, instead of being capped between a min and max, cycles between them (the bound_wrap policy).
+E.g.	cyclic<int> c(1, 0, 3);
+		c += 1;		// (0, 2, 3)
+		c += 1;		// (0, 3, 3)
+		c += 1;		// (0, 0, 3)	<-- returns back to min
+		c += 1;		// (0, 1, 3)  Repeats the cycle.
+
+	Integers cycle through [min, max], and floating point values through [min, max), so that max itself wraps to min:
+		cyclic<double> angle(0.0, 0.0, 2 * pi);
+		angle += 7.0;	// 7 - 2 pi = 0.7168...
+
+	The wrapping is done by wrap() (see wrap.h), which needs no division for values less than one range outside the limits.
 */
 template <class T>
-class cyclic : public bound<T> {
-
-protected:
-	void check() {
-		if (val > max) {
-			T range_plus_one = range() + 1;
-			val -= int((val - min) / (range_plus_one)) * (range_plus_one);
-		}
-		else if (val < min) {
-			T range_plus_one = range() + 1;
-			val += int((max - val) / (range_plus_one)) * (range_plus_one);
-		}
-	}
-
-public:
-	cyclic() : bound<T>() {}
-	cyclic(const T &val, const T &min=0, const T &max=100) : bound<T>(val, min, max) {}
-	cyclic(const cyclic& b) : bound<T>(b) {}
-	cyclic(cyclic&& b) : cyclic() { swap(b); }
-	~cyclic() {}
+using cyclic = bound<T, bound_wrap>;
 
-};
+// A cyclic with constant limits, stored as a single T (see static_bound). A range whose size is a power of two,
+// e.g. static_cyclic<unsigned, 0, 255>, wraps with a mask; any other integer range with a multiply instead of a division.
+template <class T, T Min, T Max>
+using static_cyclic = static_bound<T, Min, Max, bound_wrap>;
 
 namespace std {
 
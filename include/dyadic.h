@@ -0,0 +1,251 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include "fraction.h"
+#include "gcd.h"
+#include "int_traits.h"
+#include "typedefs.h"
+
+//	A dyadic rational: a fraction whose denominator is a power of two, e.g. 5/8 or -3/1024.
+//		Stores the numerator and the power of two: num / 2^shift (shift is negative for even whole numbers, e.g. 12 = 3 / 2^-2).
+//
+//		Int	: the signed integer of the numerator (int8_t up to __int128).
+//
+//		Always kept with an odd numerator (or 0 / 2^0), so normalising is a count of trailing zeros, and equal values have equal terms.
+//		Addition aligns the numerators by shifting, multiplication multiplies the numerators and adds the shifts, and there is
+//		no gcd anywhere, so this is a much cheaper exact tier than fraction for values like sample weights or filter taps.
+//
+//		Arithmetic is exact, or throws: std::overflow_error if the numerator does not fit in Int, and std::domain_error
+//		for a division whose result is not dyadic (e.g. 1 / 3). Intermediates are computed in wider<Int>, so aligning
+//		the terms of an addition only overflows when the result itself would not fit.
+//
+//		Converts losslessly to and from fraction (a fraction whose lowest denominator is not a power of two throws std::domain_error),
+//		and to and from double (to_double rounds to nearest if the dyadic has more significant bits than a double).
+//
+//		Header-only, and constexpr throughout (except from_double, to_double, to_string and the streams), e.g.
+//			constexpr dyadic d = dyadic(3, 2) + dyadic(1, 3);		// 3/4 + 1/8 = 7/8
+//			static_assert(d.get_num() == 7 && d.get_shift() == 3, "");
+template <class Int>
+class basic_dyadic
+{
+	static_assert(is_integer<Int>::value && Int(-1) < Int(0), "basic_dyadic requires a signed integer type");
+
+public:
+	typedef Int int_type;
+	typedef typename wider<Int>::type wide_type;
+
+private:
+	typedef typename unsigned_of<wide_type>::type U;
+
+	Int num;
+	int shift;
+
+	static constexpr U magnitude(wide_type x) noexcept { return x < 0 ? U(0) - U(x) : U(x); }
+	static constexpr int bit_length(U x) noexcept
+	{
+		int n = 0;
+		for (int s = int_limits<U>::digits / 2; s > 0; s /= 2) if (x >> s) { x >>= s; n += s; }
+		return x ? n + 1 : n;
+	}
+	template <class V> static constexpr int trailing_zeros(V x) noexcept		// x != 0
+	{
+		if constexpr (sizeof(V) <= sizeof(std::uint64_t)) return ctz(std::uint64_t(x));
+		else return ctz(x);
+	}
+	static constexpr wide_type shift_left(wide_type x, int s)
+	{
+		if (x != 0 && (s >= int_limits<wide_type>::digits || bit_length(magnitude(x)) + s > int_limits<wide_type>::digits)) throw std::overflow_error("dyadic overflow");
+		return x == 0 ? 0 : wide_type(U(x) << s);
+	}
+	constexpr void assign(wide_type n, int s);		// normalise n / 2^s, and store it if it fits
+	static constexpr int compare(const basic_dyadic& lhs, const basic_dyadic& rhs) noexcept;
+
+public:
+
+	// Construction
+
+	constexpr basic_dyadic() noexcept : num(0), shift(0) {}
+	constexpr basic_dyadic(const Int num, const int shift = 0) : num(0), shift(0) { assign(num, shift); }		// num / 2^shift
+	template <class I, class N, class O> constexpr explicit basic_dyadic(const basic_fraction<I, N, O>& f);
+	static basic_dyadic from_double(double x);		// throws std::domain_error for infinities and NaN, std::overflow_error if x has too many bits for Int
+
+	// Accessors
+
+	constexpr Int get_num() const noexcept { return num; }
+	constexpr int get_shift() const noexcept { return shift; }
+
+	// Type casts
+
+	template <class F = basic_fraction<Int> > constexpr F to_fraction() const;		// throws std::overflow_error if the terms do not fit in F
+	double to_double() const;
+	str to_string() const;
+
+	// Functions
+
+	constexpr basic_dyadic& negate() { assign(-wide_type(num), shift); return *this; }
+	constexpr basic_dyadic& ldexp(int e) { if (num != 0) shift -= e; return *this; }		// multiply by 2^e, which is exact
+
+	// Operator overloads
+
+	constexpr bool operator == (const basic_dyadic& rhs) const noexcept { return num == rhs.num && shift == rhs.shift; }
+	constexpr bool operator != (const basic_dyadic& rhs) const noexcept { return !operator==(rhs); }
+	constexpr bool operator <  (const basic_dyadic& rhs) const noexcept { return compare(*this, rhs) <  0; }
+	constexpr bool operator >  (const basic_dyadic& rhs) const noexcept { return compare(*this, rhs) >  0; }
+	constexpr bool operator <= (const basic_dyadic& rhs) const noexcept { return compare(*this, rhs) <= 0; }
+	constexpr bool operator >= (const basic_dyadic& rhs) const noexcept { return compare(*this, rhs) >= 0; }
+
+	constexpr basic_dyadic operator-() const { basic_dyadic result(*this); result.negate(); return result; }
+
+	constexpr basic_dyadic& operator += (const basic_dyadic& rhs);
+	constexpr basic_dyadic& operator -= (const basic_dyadic& rhs) { return *this += -rhs; }
+	constexpr basic_dyadic& operator *= (const basic_dyadic& rhs);
+	constexpr basic_dyadic& operator /= (const basic_dyadic& rhs);
+};
+
+typedef basic_dyadic<std::int64_t> dyadic;
+
+// Private
+
+template <class Int> constexpr void basic_dyadic<Int>::assign(wide_type n, int s)
+{
+	if (n == 0) { num = 0; shift = 0; return; }
+	int z = trailing_zeros(magnitude(n));
+	n >>= z;		// exact, as the low bits are zero
+	if (!fits<Int>(n)) throw std::overflow_error("dyadic overflow");
+	num = Int(n);
+	shift = s - z;
+}
+
+// Return the sign of lhs - rhs. The terms are normalised, so if the positions of the leading bits differ
+// they decide; otherwise aligning the numerators cannot overflow.
+template <class Int> constexpr int basic_dyadic<Int>::compare(const basic_dyadic& lhs, const basic_dyadic& rhs) noexcept
+{
+	int l = (lhs.num > 0) - (lhs.num < 0), r = (rhs.num > 0) - (rhs.num < 0);
+	if (l != r || l == 0) return (l > r) - (l < r);
+
+	int lhs_top = bit_length(magnitude(lhs.num)) - lhs.shift;
+	int rhs_top = bit_length(magnitude(rhs.num)) - rhs.shift;
+	int c = 0;
+	if (lhs_top != rhs_top) c = lhs_top > rhs_top ? 1 : -1;
+	else {
+		U a = magnitude(lhs.num), b = magnitude(rhs.num);
+		if (lhs.shift > rhs.shift) b <<= lhs.shift - rhs.shift;
+		else a <<= rhs.shift - lhs.shift;
+		c = (a > b) - (a < b);
+	}
+	return l > 0 ? c : -c;
+}
+
+// Construction
+
+template <class Int> template <class I, class N, class O>
+constexpr basic_dyadic<Int>::basic_dyadic(const basic_fraction<I, N, O>& f) : num(0), shift(0)
+{
+	typedef typename unsigned_of<I>::type UI;
+	I n = f.get_num(), d = f.get_den();
+	if (d == 0) throw std::domain_error("dyadic from a fraction with a zero denominator");
+	if (n == 0) return;
+	reduce_terms(n, d);
+	UI m = d < 0 ? UI(0) - UI(d) : UI(d);
+	if ((m & (m - 1)) != 0) throw std::domain_error("fraction is not dyadic");
+	int s = trailing_zeros(m);
+	if (!fits<wide_type>(n)) throw std::overflow_error("dyadic overflow");
+	assign(d < 0 ? -wide_type(n) : wide_type(n), s);
+}
+
+template <class Int> basic_dyadic<Int> basic_dyadic<Int>::from_double(double x)
+{
+	if (!std::isfinite(x)) throw std::domain_error("dyadic from an infinite or NaN double");
+	if (x == 0) return basic_dyadic();
+	int exponent = 0;
+	const int digits = std::numeric_limits<double>::digits;
+	std::int64_t m = std::int64_t(std::ldexp(std::frexp(x, &exponent), digits));		// x = m * 2^(exponent - digits), exactly
+	basic_dyadic result;
+	int z = ctz(std::uint64_t(m < 0 ? -m : m));
+	m /= std::int64_t(1) << z;
+	if (!fits<Int>(m)) throw std::overflow_error("dyadic overflow");
+	result.num = Int(m);
+	result.shift = digits - exponent - z;
+	return result;
+}
+
+// Type casts
+
+template <class Int> template <class F> constexpr F basic_dyadic<Int>::to_fraction() const
+{
+	typedef typename F::int_type I;
+	if (shift <= 0) {
+		wide_type n = shift_left(num, -shift);
+		if (!fits<I>(n)) throw std::overflow_error("dyadic does not fit in the fraction");
+		return F(I(n), I(1));
+	}
+	if (shift >= int_limits<I>::digits || !fits<I>(num)) throw std::overflow_error("dyadic does not fit in the fraction");
+	return F(I(num), I(I(1) << shift));
+}
+
+template <class Int> double basic_dyadic<Int>::to_double() const
+{
+	return std::ldexp(double(num), -shift);		// exact if num has at most 53 bits (and the exponent is in range), otherwise rounded to nearest
+}
+
+template <class Int> str basic_dyadic<Int>::to_string() const
+{
+	// "a/b" like fraction while the denominator fits, otherwise "a*2^-s"
+	if (shift <= 0 && -shift < int_limits<wide_type>::digits && bit_length(magnitude(num)) - shift <= int_limits<wide_type>::digits) return int_to_string(wide_type(U(wide_type(num)) << -shift));
+	if (shift > 0 && shift < int_limits<wide_type>::digits) return int_to_string(num) + "/" + int_to_string(wide_type(U(1) << shift));
+	return int_to_string(num) + "*2^" + std::to_string(-shift);
+}
+
+// Operator overloads
+
+template <class Int> constexpr basic_dyadic<Int>& basic_dyadic<Int>::operator += (const basic_dyadic& rhs)
+{
+	if (rhs.num == 0) return *this;
+	if (num == 0) return *this = rhs;
+
+	// Align to the larger shift (the finer of the two grids)
+	wide_type a = num, b = rhs.num;
+	int s = shift;
+	if (shift < rhs.shift) { a = shift_left(a, rhs.shift - shift); s = rhs.shift; }
+	else b = shift_left(b, shift - rhs.shift);
+
+	wide_type n = 0;
+	if (checked_add(a, b, n)) throw std::overflow_error("dyadic overflow");
+	assign(n, s);
+	return *this;
+}
+
+template <class Int> constexpr basic_dyadic<Int>& basic_dyadic<Int>::operator *= (const basic_dyadic& rhs)
+{
+	wide_type n = 0;
+	if (checked_mul(wide_type(num), wide_type(rhs.num), n)) throw std::overflow_error("dyadic overflow");
+	assign(n, shift + rhs.shift);		// the product of odd numerators is odd, so this only checks the range
+	return *this;
+}
+
+template <class Int> constexpr basic_dyadic<Int>& basic_dyadic<Int>::operator /= (const basic_dyadic& rhs)
+{
+	// rhs is an odd numerator times a power of two: the result is dyadic only if the odd part divides num.
+	if (rhs.num == 0) throw std::domain_error("dyadic division by zero");
+	if (wide_type(num) % rhs.num != 0) throw std::domain_error("dyadic division has no exact result");
+	assign(wide_type(num) / rhs.num, shift - rhs.shift);
+	return *this;
+}
+
+// Operator overloads : rhs arithmetic
+
+template <class I> constexpr basic_dyadic<I> operator+ (basic_dyadic<I> lhs, const basic_dyadic<I>& rhs) { lhs += rhs; return lhs; }
+template <class I> constexpr basic_dyadic<I> operator- (basic_dyadic<I> lhs, const basic_dyadic<I>& rhs) { lhs -= rhs; return lhs; }
+template <class I> constexpr basic_dyadic<I> operator* (basic_dyadic<I> lhs, const basic_dyadic<I>& rhs) { lhs *= rhs; return lhs; }
+template <class I> constexpr basic_dyadic<I> operator/ (basic_dyadic<I> lhs, const basic_dyadic<I>& rhs) { lhs /= rhs; return lhs; }
+
+template <class I> std::ostream& operator << (std::ostream& os, const basic_dyadic<I>& rhs) {
+	os << rhs.to_string();
+	return os;
+}
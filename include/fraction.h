@@ -1,126 +1,709 @@
 #pragma once
 
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include "macros.h"
 #include "typedefs.h"
+#include "int_traits.h"
+#include "gcd.h"
 
-//	To do		
+//	To do
 //		- test all functions
-//		- optimise simplify: it does additional work by checking multiples of already checked numbers,
-//			e.g. it checks 2,3,4,5,6,7,8,9 separately, however 4,6,8,9 are redundant as 2 and 3 have been checked.
-//			ultimately, it just needs to check the prime numbers. However obtaining the primes is difficult.
 //		- re-evaluate noexcept
 
+#define AUTO_SIMPLIFY	0		// Keep fractions in their lowest terms after every +=, -=, *= and /=.
+								// Products are cross-cancelled before multiplying, so intermediates stay small (and overflow much later).
+								// Off by default, as it costs a gcd per operation; call simplify() manually instead.
+								// Selects the default normalisation policy (see below), which can also be chosen per type.
+
+// Normalisation policies
+//		Decide whether the results of arithmetic are kept in lowest terms.
+//------------------------------------------------------------------------------------
+
+struct no_normalize   { static const bool enabled = false; };	// results are left as computed, call simplify() manually.
+struct auto_normalize { static const bool enabled = true;  };	// results are reduced to lowest terms (with a positive denominator).
+
+#if AUTO_SIMPLIFY
+	typedef auto_normalize default_normalize;
+#else
+	typedef no_normalize default_normalize;
+#endif
+
+// Overflow policies
+//		Sums and products are computed exactly in wider<Int>, e.g. int64_t for an int32_t fraction.
+//		The policy then decides how that exact result is stored back into two Ints:
+//			overflow_wrap		: truncate (two's complement wrap-around), i.e. the behaviour of plain int arithmetic.
+//			overflow_saturate	: clamp the value to [min/1, max/1], or approximate it when only the terms are too large.
+//			overflow_throw		: throw std::overflow_error if either term does not fit.
+//			overflow_promote	: reduce to lowest terms in the wider type first, and only throw if that still does not fit.
+//		The widest backing type (__int128) has no wider type, so overflowed intermediates are detected instead (overflowed = true).
+//		approx() returns the value as a long double, and is only called when a policy needs it.
+//------------------------------------------------------------------------------------
+
+// Divide n and d by their greatest common divisor, and make d positive.
+template <class Wide> constexpr void reduce_terms(Wide& n, Wide& d) noexcept
+{
+	Wide divisor = gcd(n, d);
+	if (divisor > 1) { n /= divisor; d /= divisor; }
+	if (d < 0) { n = -n; d = -d; }
+}
+
+struct overflow_wrap {
+	template <class Int, class Wide, class Approx>
+	static constexpr void store(Int& num, Int& den, Wide n, Wide d, bool, Approx) noexcept { num = Int(n); den = Int(d); }
+};
+
+struct overflow_saturate {
+	template <class Int, class Wide, class Approx>
+	static constexpr void store(Int& num, Int& den, Wide n, Wide d, bool overflowed, Approx approx) noexcept
+	{
+		if (!overflowed)
+		{
+			if (fits<Int>(n) && fits<Int>(d)) { num = Int(n); den = Int(d); return; }
+			reduce_terms(n, d);
+			if (fits<Int>(n) && fits<Int>(d)) { num = Int(n); den = Int(d); return; }
+		}
+		long double value = overflowed ? approx() : (long double)n / (long double)d;
+		const long double limit = (long double)int_limits<Int>::max();
+
+		if (value != value) { num = 0; den = 0; }
+		else if (value >=  limit) { num = int_limits<Int>::max(); den = 1; }
+		else if (value <= -limit) { num = int_limits<Int>::min(); den = 1; }
+		else
+		{
+			// In range, but the terms are too large: approximate by value * 2^shift / 2^shift, using all the bits of Int.
+			int exponent = 0;
+			std::frexp(value, &exponent);		// |value| < 2^exponent
+			int shift = int_limits<Int>::digits - 1 - (exponent > 0 ? exponent : 0);
+			n = Wide(std::ldexp(value, shift) + (value < 0 ? -0.5L : 0.5L));
+			d = Wide(1) << shift;
+			reduce_terms(n, d);
+			num = Int(n); den = Int(d);
+		}
+	}
+};
+
+struct overflow_throw {
+	template <class Int, class Wide, class Approx>
+	static constexpr void store(Int& num, Int& den, Wide n, Wide d, bool overflowed, Approx)
+	{
+		if (overflowed || !fits<Int>(n) || !fits<Int>(d)) throw std::overflow_error("fraction overflow");
+		num = Int(n); den = Int(d);
+	}
+};
+
+struct overflow_promote {
+	template <class Int, class Wide, class Approx>
+	static constexpr void store(Int& num, Int& den, Wide n, Wide d, bool overflowed, Approx)
+	{
+		if (!overflowed && !(fits<Int>(n) && fits<Int>(d))) reduce_terms(n, d);
+		if (overflowed || !fits<Int>(n) || !fits<Int>(d)) throw std::overflow_error("fraction overflow");
+		num = Int(n); den = Int(d);
+	}
+};
+
 //	A fraction of integers, e.g. 5/3 or -27/4
 //		Stores the numerator and denominator of the fraction: 5 and 3.
-//		Implementation mostly in fraction.cpp
-class fraction
+//
+//		Int			: the signed integer used for the numerator and denominator (int8_t up to __int128).
+//		Normalize	: normalisation policy, see above.
+//		Overflow	: overflow policy, see above.
+//
+//		Comparisons are always exact: the cross products are computed in wider<Int> (or in double-width
+//		unsigned arithmetic for the widest type), so they cannot overflow. So are comparisons with float and double,
+//		and from_double() gives the closest fraction to a double with a bounded denominator.
+//
+//		Header-only, and constexpr throughout (except to_string, the streams and floating point powers and comparisons), e.g.
+//			constexpr fraction f = fraction(1, 2) * fraction(2, 3);	// folded by the compiler
+//			static_assert(f == fraction(1, 3), "");
+//
+//		fraction is basic_fraction<int> with wrap-around overflow, i.e. the original behaviour of this class.
+//		Pick the narrowest backing type that is safe for the workload, e.g. fraction64 or basic_fraction<int, auto_normalize, overflow_throw>.
+template <class Int, class Normalize = default_normalize, class Overflow = overflow_wrap>
+class basic_fraction
 {
+	static_assert(is_integer<Int>::value && Int(-1) < Int(0), "basic_fraction requires a signed integer type");
+
+public:
+	typedef Int int_type;
+	typedef typename wider<Int>::type wide_type;
+	typedef Normalize normalize_policy;
+	typedef Overflow overflow_policy;
+
 private:
-	int num, den;
+	Int num, den;
+
+	template <class Approx> constexpr void assign(wide_type n, wide_type d, bool overflowed, Approx approx);
+	constexpr void add(wide_type rhs_num, Int rhs_den, bool overflowed = false);
+	constexpr void multiply(Int rhs_num, Int rhs_den);
+	static constexpr int compare(Int lhs_num, Int lhs_den, Int rhs_num, Int rhs_den) noexcept;
+	template <class F> int compare_float(F x) const noexcept;
+	template <class W> static basic_fraction continued_fraction(W p, W q, W max_num, W max_k, bool negative);
 
 public:
 
 	// Construction
 
-	fraction() noexcept;
-	fraction(cint num, cint den) noexcept;
-	fraction(const fraction&) noexcept = default;
-	fraction(fraction&& f) noexcept = default;
-	~fraction();
+	constexpr basic_fraction() noexcept;
+	constexpr basic_fraction(const Int num, const Int den) noexcept;
+	constexpr explicit basic_fraction(const Int num) noexcept;
+	static basic_fraction from_double(double x, Int max_den = int_limits<Int>::max());
+	template <class I, class N, class O> constexpr explicit basic_fraction(const basic_fraction<I, N, O>& f);
+	constexpr basic_fraction(const basic_fraction&) noexcept = default;
+	constexpr basic_fraction(basic_fraction&& f) noexcept = default;
+	~basic_fraction() = default;
 
 	// Accessors
 
-	 int& get_num() noexcept;
-	cint& get_num() const;
-	 int& get_den() noexcept;
-	cint& get_den() const;
-	void  set_num(cint n) noexcept;
-	void  set_den(cint d) noexcept;
+	constexpr       Int& get_num() noexcept;
+	constexpr const Int& get_num() const;
+	constexpr       Int& get_den() noexcept;
+	constexpr const Int& get_den() const;
+	constexpr void  set_num(const Int n) noexcept;
+	constexpr void  set_den(const Int d) noexcept;
 
 	// Type casts
 
-	int			to_int		() const;
-	long		to_long		() const;
-	float		to_float	() const;
-	double		to_double	() const;
-	long long	to_long_long() const;
+	constexpr int		to_int		() const;
+	constexpr long		to_long		() const;
+	constexpr float		to_float	() const;
+	constexpr double	to_double	() const;
+	constexpr long long	to_long_long() const;
 	str to_string() const;
 
-	operator int   () const;
-	operator float () const;
-	operator double() const;
+	constexpr operator int   () const;
+	constexpr operator float () const;
+	constexpr operator double() const;
 
 	// Functions
 
-	fraction& simplify();
-	fraction& invert() noexcept;
-	fraction& negate() noexcept;
-	fraction& power(const fraction &n);
-	template <class number>	fraction& power(const number n)
+	constexpr basic_fraction& simplify() noexcept;
+	constexpr basic_fraction& invert() noexcept;
+	constexpr basic_fraction& negate();
+	template <class I, typename std::enable_if<is_integer<I>::value, int>::type = 0> constexpr basic_fraction& power(const I n);
+	constexpr basic_fraction& power(const basic_fraction& n);		// throws std::domain_error if the result is not exact
+	constexpr bool try_power(const basic_fraction& n);				// returns false (and leaves the fraction unchanged) instead
+	template <class F, typename std::enable_if<std::is_floating_point<F>::value, int>::type = 0> basic_fraction& power(const F n)
 	{
-		num = std::pow(num, n);
-		den = std::pow(den, n);
+		// Approximate: there is no exact result in general.
+		num = Int(std::pow((long double)num, n));
+		den = Int(std::pow((long double)den, n));
 		return *this;
 	}
 
 	// Operator overloads
 
-	bool operator == (const fraction& rhs) const;
-	bool operator != (const fraction& rhs) const;
-	bool operator <  (const fraction& rhs) const;
-	bool operator >  (const fraction& rhs) const;
-	bool operator <= (const fraction& rhs) const;
-	bool operator >= (const fraction& rhs) const;
-
-	bool operator == (const int& rhs) const;
-	bool operator != (const int& rhs) const;
-	bool operator <  (const int& rhs) const;
-	bool operator >  (const int& rhs) const;
-	bool operator <= (const int& rhs) const;
-	bool operator >= (const int& rhs) const;
-
-	bool operator == (const float& rhs) const;
-	bool operator != (const float& rhs) const;
-	bool operator <  (const float& rhs) const;
-	bool operator >  (const float& rhs) const;
-	bool operator <= (const float& rhs) const;
-	bool operator >= (const float& rhs) const;
-
-	fraction operator-() const;
-	fraction& operator++();
-	fraction& operator--();
-	const fraction operator++(int unused);
-	const fraction operator--(int unused);
-
-	fraction& operator  = (fraction rhs) noexcept;
-	fraction& operator += (const fraction& rhs);
-	fraction& operator -= (const fraction& rhs);
-	fraction& operator *= (const fraction& rhs);
-	fraction& operator /= (const fraction& rhs);
-
-	fraction& operator  = (cint &rhs) noexcept;
-	fraction& operator *= (cint &rhs);
-	fraction& operator /= (cint &rhs);
-	fraction& operator += (cint &rhs);
-	fraction& operator -= (cint &rhs);
+	constexpr bool operator == (const basic_fraction& rhs) const;
+	constexpr bool operator != (const basic_fraction& rhs) const;
+	constexpr bool operator <  (const basic_fraction& rhs) const;
+	constexpr bool operator >  (const basic_fraction& rhs) const;
+	constexpr bool operator <= (const basic_fraction& rhs) const;
+	constexpr bool operator >= (const basic_fraction& rhs) const;
+
+	template <class I, class = typename std::enable_if<is_integer<I>::value>::type> constexpr bool operator == (const I& rhs) const { return compare(num, den, Int(rhs), 1) == 0; }
+	template <class I, class = typename std::enable_if<is_integer<I>::value>::type> constexpr bool operator != (const I& rhs) const { return compare(num, den, Int(rhs), 1) != 0; }
+	template <class I, class = typename std::enable_if<is_integer<I>::value>::type> constexpr bool operator <  (const I& rhs) const { return compare(num, den, Int(rhs), 1) <  0; }
+	template <class I, class = typename std::enable_if<is_integer<I>::value>::type> constexpr bool operator >  (const I& rhs) const { return compare(num, den, Int(rhs), 1) >  0; }
+	template <class I, class = typename std::enable_if<is_integer<I>::value>::type> constexpr bool operator <= (const I& rhs) const { return compare(num, den, Int(rhs), 1) <= 0; }
+	template <class I, class = typename std::enable_if<is_integer<I>::value>::type> constexpr bool operator >= (const I& rhs) const { return compare(num, den, Int(rhs), 1) >= 0; }
+
+	// Comparisons with float, double and long double are exact too (NaN is unordered, as for floating point)
+	template <class F, typename std::enable_if<std::is_floating_point<F>::value, int>::type = 0> bool operator == (const F& rhs) const { return compare_float(rhs) == 0; }
+	template <class F, typename std::enable_if<std::is_floating_point<F>::value, int>::type = 0> bool operator != (const F& rhs) const { return compare_float(rhs) != 0; }
+	template <class F, typename std::enable_if<std::is_floating_point<F>::value, int>::type = 0> bool operator <  (const F& rhs) const { return compare_float(rhs) == -1; }
+	template <class F, typename std::enable_if<std::is_floating_point<F>::value, int>::type = 0> bool operator >  (const F& rhs) const { return compare_float(rhs) == 1; }
+	template <class F, typename std::enable_if<std::is_floating_point<F>::value, int>::type = 0> bool operator <= (const F& rhs) const { int c = compare_float(rhs); return c == -1 || c == 0; }
+	template <class F, typename std::enable_if<std::is_floating_point<F>::value, int>::type = 0> bool operator >= (const F& rhs) const { int c = compare_float(rhs); return c == 1 || c == 0; }
+
+	constexpr basic_fraction operator-() const;
+	constexpr basic_fraction& operator++();
+	constexpr basic_fraction& operator--();
+	constexpr const basic_fraction operator++(int unused);
+	constexpr const basic_fraction operator--(int unused);
+
+	constexpr basic_fraction& operator  = (const basic_fraction& rhs) noexcept = default;
+	constexpr basic_fraction& operator  = (basic_fraction&& rhs) noexcept = default;
+	constexpr basic_fraction& operator += (const basic_fraction& rhs);
+	constexpr basic_fraction& operator -= (const basic_fraction& rhs);
+	constexpr basic_fraction& operator *= (const basic_fraction& rhs);
+	constexpr basic_fraction& operator /= (const basic_fraction& rhs);
+
+	constexpr basic_fraction& operator  = (const Int &rhs) noexcept;
+	constexpr basic_fraction& operator *= (const Int &rhs);
+	constexpr basic_fraction& operator /= (const Int &rhs);
+	constexpr basic_fraction& operator += (const Int &rhs);
+	constexpr basic_fraction& operator -= (const Int &rhs);
 
 };
 
-template <class T> fraction operator+ (fraction lhs, const T& rhs) { lhs += rhs; return lhs; }
-template <class T> fraction operator- (fraction lhs, const T& rhs) { lhs -= rhs; return lhs; }
-template <class T> fraction operator* (fraction lhs, const T& rhs) { lhs *= rhs; return lhs; }
-template <class T> fraction operator/ (fraction lhs, const T& rhs) { lhs /= rhs; return lhs; }
+typedef basic_fraction<int> fraction;
+typedef basic_fraction<std::int64_t> fraction64;
+#if HAS_INT128
+typedef basic_fraction<int128_t> fraction128;
+#endif
+
+// Parsing and formatting
+//		Like std::from_chars and std::to_chars: they work on the caller's buffer, and never allocate, throw or use the locale.
+//		The format is that of to_string: "a/b", or just "a" for a whole number (whose denominator is then 1).
+//------------------------------------------------------------------------------------
+
+const std::size_t fraction_chars = 2 * 41 + 1;	// enough for any fraction, up to two 128 bit terms and the '/'
+
+// Parse a fraction from [first, last). On error (ec is set) value is left unchanged.
+// A '/' that is not followed by a denominator is not part of the fraction, e.g. "3/" parses as 3, and ptr points at the '/'.
+template <class I, class N, class O> std::from_chars_result from_chars(const char* first, const char* last, basic_fraction<I, N, O>& value) noexcept
+{
+	I n = 0, d = 1;
+	std::from_chars_result result = int_from_chars(first, last, n);
+	if (result.ec != std::errc()) return result;
+	if (result.ptr != last && *result.ptr == '/') {
+		std::from_chars_result denominator = int_from_chars(result.ptr + 1, last, d);
+		if (denominator.ec == std::errc::result_out_of_range) return denominator;
+		if (denominator.ec == std::errc()) result.ptr = denominator.ptr;
+	}
+	value.set_num(n);
+	value.set_den(d);
+	return result;
+}
+
+// Write value to [first, last). ec is value_too_large if it does not fit (fraction_chars always does).
+template <class I, class N, class O> std::to_chars_result to_chars(char* first, char* last, const basic_fraction<I, N, O>& value) noexcept
+{
+	std::to_chars_result result = int_to_chars(first, last, value.get_num());
+	if (result.ec != std::errc() || value.get_den() == 1) return result;
+	if (result.ptr == last) return { last, std::errc::value_too_large };
+	*result.ptr = '/';
+	return int_to_chars(result.ptr + 1, last, value.get_den());
+}
+
+// Parse a buffer of fractions separated by commas and/or whitespace, e.g. "1/2, 3/4 5", appending them to out.
+// Stops at the end of the buffer, or at the first token that is not a fraction: ptr then points at it, and ec is set.
+template <class F> std::from_chars_result parse_fractions(const char* first, const char* last, std::vector<F>& out)
+{
+	auto separator = [](char c) { return c == ',' || c == ' ' || (c >= '\t' && c <= '\r'); };
+	for (;;) {
+		while (first != last && separator(*first)) ++first;
+		if (first == last) return { last, std::errc() };
+
+		F f;
+		std::from_chars_result result = from_chars(first, last, f);
+		if (result.ec != std::errc()) return { first, result.ec };
+		if (result.ptr != last && !separator(*result.ptr)) return { first, std::errc::invalid_argument };
+		out.push_back(f);
+		first = result.ptr;
+	}
+}
+
+// Construction
+
+template <class Int, class N, class O> constexpr basic_fraction<Int, N, O>::basic_fraction() noexcept : num(), den() {}
+template <class Int, class N, class O> constexpr basic_fraction<Int, N, O>::basic_fraction(const Int num, const Int den) noexcept : num(num), den(den) {}
+template <class Int, class N, class O> constexpr basic_fraction<Int, N, O>::basic_fraction(const Int num) noexcept : num(num), den(1) {}
+template <class Int, class N, class O> template <class I, class N2, class O2>
+constexpr basic_fraction<Int, N, O>::basic_fraction(const basic_fraction<I, N2, O2>& f) : num(), den()
+{
+	I n = f.get_num(), d = f.get_den();
+	if (N::enabled) reduce_terms(n, d);
+	O::store(num, den, n, d, false, [&] { return (long double)n / (long double)d; });
+}
+
+// Return the fraction closest to x with a denominator of at most max_den (and a numerator that fits in Int),
+// e.g. from_double(3.14159, 1000) = 355/113. Ties go to the smaller denominator.
+//		x is first written exactly as p / 2^k, then expanded as a continued fraction. The best approximation is
+//		the last convergent within the bounds, or the semiconvergent after it, so this takes O(log max_den) steps.
+//		NaN gives 0/0, and infinities (and values too large for Int) give +-1/0 (or +-max/1).
+template <class Int, class N, class O> basic_fraction<Int, N, O> basic_fraction<Int, N, O>::from_double(double x, Int max_den)
+{
+#if HAS_INT128
+	typedef uint128_t W;
+#else
+	typedef std::uint64_t W;
+#endif
+	static_assert(sizeof(W) >= sizeof(Int), "from_double needs an unsigned integer as wide as Int");
+
+	if (x != x) return basic_fraction(0, 0);
+	const bool negative = x < 0;
+	const W max_num = W(int_limits<Int>::max());
+	const W max_k = max_den < 1 ? 1 : W(max_den);
+	x = std::fabs(x);
+	if (std::isinf(x)) return basic_fraction(negative ? -1 : 1, 0);
+	if (x == 0) return basic_fraction(0, 1);
+
+	// x = p * 2^shift exactly, with p odd. The fields of the IEEE double are read directly: frexp is much slower.
+	static_assert(std::numeric_limits<double>::is_iec559, "from_double requires IEEE doubles");
+	const int digits = std::numeric_limits<double>::digits;
+	std::uint64_t p = 0;
+	std::memcpy(&p, &x, sizeof(p));
+	int biased = int(p >> (digits - 1));
+	p &= (std::uint64_t(1) << (digits - 1)) - 1;
+	if (biased != 0) p |= std::uint64_t(1) << (digits - 1);		// normal: add the implicit leading 1
+	else biased = 1;
+	int exponent = biased - 1022;		// x < 2^exponent, as for frexp
+	int shift = exponent - digits + ctz(p);
+	p >>= ctz(p);
+	if (exponent > int_limits<Int>::digits) return continued_fraction<W>(max_num, 1, max_num, max_k, negative);
+
+	// Most values fit in 64 bits as p / q, which is much faster than 128 bit arithmetic.
+	if (sizeof(Int) <= 8 && shift > -64) {
+		if (shift >= 0) return continued_fraction<std::uint64_t>(p << shift, 1, std::uint64_t(max_num), std::uint64_t(max_k), negative);
+		return continued_fraction<std::uint64_t>(p, std::uint64_t(1) << -shift, std::uint64_t(max_num), std::uint64_t(max_k), negative);
+	}
+	if (shift >= 0) return continued_fraction<W>(W(p) << shift, 1, max_num, max_k, negative);
+
+	// The low bits of tiny values are rounded away, as q is at most 2^(bits of W - 1).
+	const int max_shift = int_limits<W>::digits - 1;
+	W wp = p;
+	if (-shift > max_shift) {
+		int drop = -shift - max_shift;
+		wp = drop > digits ? 0 : (wp >> (drop - 1)) - (wp >> drop);		// round to nearest: the shifted value, plus the last bit shifted out
+		shift = -max_shift;
+	}
+	return continued_fraction<W>(wp, W(1) << -shift, max_num, max_k, negative);
+}
+
+// Return the best approximation to p / q, with a numerator of at most max_num and a denominator of at most max_k.
+template <class Int, class N, class O> template <class W>
+basic_fraction<Int, N, O> basic_fraction<Int, N, O>::continued_fraction(W p, W q, W max_num, W max_k, bool negative)
+{
+	auto result = [negative](W n, W d) { return basic_fraction(negative ? -Int(n) : Int(n), Int(d)); };
+
+	// Convergents h/k, starting from h(-2)/k(-2) = 0/1 and h(-1)/k(-1) = 1/0
+	W h0 = 0, h1 = 1, k0 = 1, k1 = 0;
+	while (true) {
+		W a = p / q;
+		W h2 = 0, k2 = 0;
+		bool overflowed  = checked_mul(a, h1, h2) || checked_add(h2, h0, h2) || h2 > max_num;
+		     overflowed |= checked_mul(a, k1, k2) || checked_add(k2, k0, k2) || k2 > max_k;
+
+		if (overflowed) {
+			// The next convergent is out of bounds. Take the semiconvergent (t h1 + h0) / (t k1 + k0), with the largest t
+			// in bounds, if it is closer to x than h1 / k1, i.e. if k1 (p - t q) < (t k1 + k0) q, where p / q is the
+			// remainder of the continued fraction.
+			W t = a;
+			if (h1 != 0 && (max_num - h0) / h1 < t) t = (max_num - h0) / h1;
+			if (k1 != 0 && (max_k   - k0) / k1 < t) t = (max_k   - k0) / k1;
+			if (t > 0) {
+				W ks = t * k1 + k0;
+				W lh = 0, ll = 0, rh = 0, rl = 0;
+				mul_full(k1, p - t * q, lh, ll);
+				mul_full(ks, q, rh, rl);
+				if (lh < rh || (lh == rh && ll < rl)) return result(t * h1 + h0, ks);
+			}
+			return result(h1, k1);
+		}
+
+		h0 = h1; h1 = h2;
+		k0 = k1; k1 = k2;
+
+		W r = p - a * q;
+		if (r == 0) return result(h1, k1);
+		p = q; q = r;
+	}
+}
+
+// Accessors
+
+template <class Int, class N, class O> constexpr       Int& basic_fraction<Int, N, O>::get_num() noexcept { return num; }
+template <class Int, class N, class O> constexpr const Int& basic_fraction<Int, N, O>::get_num() const { return num; }
+template <class Int, class N, class O> constexpr       Int& basic_fraction<Int, N, O>::get_den() noexcept { return den; }
+template <class Int, class N, class O> constexpr const Int& basic_fraction<Int, N, O>::get_den() const { return den; }
+template <class Int, class N, class O> constexpr void basic_fraction<Int, N, O>::set_num(const Int n) noexcept { num = n; }
+template <class Int, class N, class O> constexpr void basic_fraction<Int, N, O>::set_den(const Int d) noexcept { den = d; }
+
+// Type casts
+
+template <class Int, class N, class O> constexpr int		basic_fraction<Int, N, O>::to_int() const { return (int)(num / den); }
+template <class Int, class N, class O> constexpr long		basic_fraction<Int, N, O>::to_long() const { return (long)(num / den); }
+template <class Int, class N, class O> constexpr float		basic_fraction<Int, N, O>::to_float() const { return (float)num / (float)den; }
+template <class Int, class N, class O> constexpr double		basic_fraction<Int, N, O>::to_double() const { return (double)num / (double)den; }
+template <class Int, class N, class O> constexpr long long	basic_fraction<Int, N, O>::to_long_long() const { return (long long)(num / den); }
+template <class Int, class N, class O> str basic_fraction<Int, N, O>::to_string() const {
+	char buffer[fraction_chars];
+	return str(buffer, to_chars(buffer, buffer + sizeof(buffer), *this).ptr);
+}
+
+template <class Int, class N, class O> constexpr basic_fraction<Int, N, O>::operator int() const { return to_int(); }
+template <class Int, class N, class O> constexpr basic_fraction<Int, N, O>::operator float() const { return to_float(); }
+template <class Int, class N, class O> constexpr basic_fraction<Int, N, O>::operator double() const { return to_double(); }
+
+// Functions
+
+// Divide through by the greatest common divisor (binary gcd, see gcd.h), and move the sign onto the numerator.
+template <class Int, class N, class O> constexpr basic_fraction<Int, N, O>& basic_fraction<Int, N, O>::simplify() noexcept
+{
+	reduce_terms(num, den);
+	return *this;
+}
+template <class Int, class N, class O> constexpr basic_fraction<Int, N, O>& basic_fraction<Int, N, O>::invert() noexcept {
+	Int n = num; num = den; den = n;
+	if (N::enabled && den < 0) { num = -num; den = -den; }
+	return *this;
+}
+template <class Int, class N, class O> constexpr basic_fraction<Int, N, O>& basic_fraction<Int, N, O>::negate() {
+	wide_type n = 0;
+	bool overflowed = checked_sub<wide_type>(0, num, n);
+	O::store(num, den, n, wide_type(den), overflowed, [&] { return -(long double)num / (long double)den; });
+	return *this;
+}
+
+// Exponentiation by squaring, of each term in wide_type: O(log n) multiplications, all overflow checked.
+// Negative powers invert first. The result is then stored by the overflow policy, like any other arithmetic.
+template <class Int, class N, class O> template <class I, typename std::enable_if<is_integer<I>::value, int>::type>
+constexpr basic_fraction<Int, N, O>& basic_fraction<Int, N, O>::power(const I n)
+{
+	typedef typename unsigned_of<I>::type U;
+	U e = n < 0 ? U(0) - U(n) : U(n);
+	wide_type a = num, b = den;
+	if (N::enabled) reduce_terms(a, b);		// then the powers are in lowest terms too
+	if (n < 0) {
+		wide_type t = a; a = b; b = t;
+		if (N::enabled && b < 0) { a = -a; b = -b; }
+	}
+
+	wide_type result_num = 1, result_den = 1;
+	bool overflowed = false;
+	for (; e != 0; e >>= 1) {
+		if (e & 1) {
+			overflowed |= checked_mul(result_num, a, result_num);
+			overflowed |= checked_mul(result_den, b, result_den);
+		}
+		if (e > 1) {
+			overflowed |= checked_mul(a, a, a);
+			overflowed |= checked_mul(b, b, b);
+		}
+	}
+	O::store(num, den, result_num, result_den, overflowed, [&] { return std::pow((long double)num / (long double)den, (long double)n); });
+	return *this;
+}
+
+// Raise to the rational power p/q, i.e. take the q-th root and raise it to the power p. The root is only taken
+// if it is exact: both terms (in lowest terms) must be perfect q-th powers, and the fraction must be positive if q is even.
+template <class Int, class N, class O> constexpr bool basic_fraction<Int, N, O>::try_power(const basic_fraction& n)
+{
+	Int p = n.num, q = n.den;
+	reduce_terms(p, q);
+	if (q == 0) return false;
+	if (q == 1) { basic_fraction result(*this); result.power(p); *this = result; return true; }
+
+	typedef typename unsigned_of<Int>::type U;
+	const Int digits = int_limits<U>::digits;
+	unsigned degree = q < digits ? unsigned(q) : unsigned(digits);		// higher roots of anything but 0 and 1 are never whole
+	Int a = num, b = den;
+	reduce_terms(a, b);
+	if (b == 0 || (a < 0 && q % 2 == 0)) return false;
+
+	U root_num = 0, root_den = 0;
+	if (!exact_root(a < 0 ? U(0) - U(a) : U(a), degree, root_num) || !exact_root(U(b), degree, root_den)) return false;
+	// Raised in a copy, as power() can throw on overflow: the fraction is only changed once the whole result is known.
+	basic_fraction result(*this);
+	result.num = a < 0 ? Int(U(0) - root_num) : Int(root_num);
+	result.den = Int(root_den);
+	result.power(p);
+	*this = result;
+	return true;
+}
+
+template <class Int, class N, class O> constexpr basic_fraction<Int, N, O>& basic_fraction<Int, N, O>::power(const basic_fraction& n)
+{
+	if (!try_power(n)) throw std::domain_error("fraction power has no exact result");
+	return *this;
+}
+
+// Arithmetic
+//		Every intermediate is computed (and overflow checked) in wide_type, then handed to the policies.
+
+template <class Int, class N, class O> template <class Approx>
+constexpr void basic_fraction<Int, N, O>::assign(wide_type n, wide_type d, bool overflowed, Approx approx)
+{
+	if (N::enabled && !overflowed) reduce_terms(n, d);
+	O::store(num, den, n, d, overflowed, approx);
+}
+
+// rhs_num is wide, so that subtraction can negate it without overflowing.
+template <class Int, class N, class O> constexpr void basic_fraction<Int, N, O>::add(wide_type rhs_num, Int rhs_den, bool overflowed)
+{
+	auto approx = [&] { return (long double)num / den + (long double)rhs_num / rhs_den; };
+	wide_type n = 0, d = 0, a = 0, b = 0;
+
+	if (den == rhs_den) {
+		overflowed |= checked_add<wide_type>(num, rhs_num, n);
+		d = den;
+	}
+	else if (N::enabled) {
+		// Scale both fractions up to the lowest common denominator, rather than the product of the denominators.
+		Int divisor = gcd(den, rhs_den);
+		overflowed |= checked_mul<wide_type>(num, rhs_den / divisor, a);
+		overflowed |= checked_mul<wide_type>(rhs_num, den / divisor, b);
+		overflowed |= checked_add<wide_type>(a, b, n);
+		overflowed |= checked_mul<wide_type>(den / divisor, rhs_den, d);
+	}
+	else {
+		overflowed |= checked_mul<wide_type>(num, rhs_den, a);
+		overflowed |= checked_mul<wide_type>(rhs_num, den, b);
+		overflowed |= checked_add<wide_type>(a, b, n);
+		overflowed |= checked_mul<wide_type>(den, rhs_den, d);
+	}
+	assign(n, d, overflowed, approx);
+}
+
+template <class Int, class N, class O> constexpr void basic_fraction<Int, N, O>::multiply(Int rhs_num, Int rhs_den)
+{
+	auto approx = [&] { return ((long double)num / den) * ((long double)rhs_num / rhs_den); };
+	Int a = num, b = den;
+
+	if (N::enabled) {
+		// Cross-cancel, so that the products (and the gcd of the result) stay small.
+		Int x = gcd(a, rhs_den), y = gcd(rhs_num, b);
+		if (x > 1) { a /= x; rhs_den /= x; }
+		if (y > 1) { rhs_num /= y; b /= y; }
+	}
+
+	wide_type n = 0, d = 0;
+	bool overflowed  = checked_mul<wide_type>(a, rhs_num, n);
+	     overflowed |= checked_mul<wide_type>(b, rhs_den, d);
+	assign(n, d, overflowed, approx);
+}
+
+// Return the sign of lhs - rhs, exactly.
+template <class Int, class N, class O> constexpr int basic_fraction<Int, N, O>::compare(Int lhs_num, Int lhs_den, Int rhs_num, Int rhs_den) noexcept
+{
+	int c = 0;
+	if constexpr (has_wider<Int>::value) {
+		wide_type l = wide_type(lhs_num) * rhs_den;
+		wide_type r = wide_type(rhs_num) * lhs_den;
+		c = (l > r) - (l < r);
+	}
+	else {
+		// Compare the signs of the cross products first, then their magnitudes in double-width unsigned arithmetic.
+		typedef typename unsigned_of<Int>::type U;
+		auto sign = [](Int x) { return (x > 0) - (x < 0); };
+		auto magnitude = [](Int x) { return x < 0 ? U(0) - U(x) : U(x); };
+
+		int l = sign(lhs_num) * sign(rhs_den);
+		int r = sign(rhs_num) * sign(lhs_den);
+		if (l != r || l == 0) c = (l > r) - (l < r);
+		else {
+			U lh = 0, ll = 0, rh = 0, rl = 0;
+			mul_full(magnitude(lhs_num), magnitude(rhs_den), lh, ll);
+			mul_full(magnitude(rhs_num), magnitude(lhs_den), rh, rl);
+			int m = lh != rh ? (lh > rh) - (lh < rh) : (ll > rl) - (ll < rl);
+			c = l > 0 ? m : -m;
+		}
+	}
+	return ((lhs_den < 0) != (rhs_den < 0)) ? -c : c;		// the cross multiplication flipped the inequality
+}
+
+// Return the sign of *this - x, exactly, or 2 if they are unordered (either is NaN).
+//		x is split into an integer mantissa and a power of two, x = m * 2^e, and num / den is compared with it
+//		as |num| * 2^-e against m * |den| (if e < 0) or |num| against m * |den| * 2^e, in 256 bit arithmetic.
+template <class Int, class N, class O> template <class F> int basic_fraction<Int, N, O>::compare_float(F x) const noexcept
+{
+	if (den == 0 || !std::isfinite(x)) {
+		// Infinities and NaN compare as floating point. A finite fraction only matters by its sign against an infinity.
+		F value = den == 0 ? F(num) / F(den) : F((num > 0) - (num < 0));
+		return value < x ? -1 : value > x ? 1 : value == x ? 0 : 2;
+	}
+
+	typedef typename unsigned_of<Int>::type U;
+	int sign   = ((num > 0) - (num < 0)) * (den < 0 ? -1 : 1);
+	int x_sign = (x > 0) - (x < 0);
+	if (sign != x_sign || sign == 0) return (sign > x_sign) - (sign < x_sign);
+
+	const int digits = std::numeric_limits<F>::digits;		// 64 bits at most (long double), so that the mantissa fits in a uint64_t
+	int exponent = 0;
+	std::uint64_t mantissa = std::uint64_t(std::ldexp(std::fabs(std::frexp(x, &exponent)), digits));
+	int e = exponent - digits;
+
+	uint256 lhs(num < 0 ? U(0) - U(num) : U(num));
+	uint256 rhs(den < 0 ? U(0) - U(den) : U(den));
+	rhs.multiply(mantissa);
+
+	// Compare the lengths first: this also bounds the shift, so that the shifted value fits.
+	int lhs_bits = lhs.bits() + (e < 0 ? -e : 0);
+	int rhs_bits = rhs.bits() + (e > 0 ?  e : 0);
+	int c = 0;
+	if (lhs_bits != rhs_bits) c = lhs_bits > rhs_bits ? 1 : -1;
+	else {
+		if (e < 0) lhs.shift_left(-e);
+		else rhs.shift_left(e);
+		c = lhs.compare(rhs);
+	}
+	return sign > 0 ? c : -c;
+}
+
+// Operator overloads
+
+template <class Int, class N, class O> constexpr bool basic_fraction<Int, N, O>::operator == (const basic_fraction& rhs) const { return compare(num, den, rhs.num, rhs.den) == 0; }
+template <class Int, class N, class O> constexpr bool basic_fraction<Int, N, O>::operator != (const basic_fraction& rhs) const { return !operator==(rhs); }
+template <class Int, class N, class O> constexpr bool basic_fraction<Int, N, O>::operator <  (const basic_fraction& rhs) const { return compare(num, den, rhs.num, rhs.den) <  0; }
+template <class Int, class N, class O> constexpr bool basic_fraction<Int, N, O>::operator >  (const basic_fraction& rhs) const { return compare(num, den, rhs.num, rhs.den) >  0; }
+template <class Int, class N, class O> constexpr bool basic_fraction<Int, N, O>::operator <= (const basic_fraction& rhs) const { return !operator>(rhs); }
+template <class Int, class N, class O> constexpr bool basic_fraction<Int, N, O>::operator >= (const basic_fraction& rhs) const { return !operator<(rhs); }
+
+template <class Int, class N, class O> constexpr basic_fraction<Int, N, O> basic_fraction<Int, N, O>::operator-() const { basic_fraction result(*this); result.negate(); return result; }
+template <class Int, class N, class O> constexpr basic_fraction<Int, N, O>& basic_fraction<Int, N, O>::operator++() { add(1, 1); return *this; }
+template <class Int, class N, class O> constexpr basic_fraction<Int, N, O>& basic_fraction<Int, N, O>::operator--() { add(-1, 1); return *this; }
+template <class Int, class N, class O> constexpr const basic_fraction<Int, N, O> basic_fraction<Int, N, O>::operator++(int unused) {
+	basic_fraction result(*this);
+	++(*this);
+	return result;
+}
+template <class Int, class N, class O> constexpr const basic_fraction<Int, N, O> basic_fraction<Int, N, O>::operator--(int unused) {
+	basic_fraction result(*this);
+	--(*this);
+	return result;
+}
+
+template <class Int, class N, class O> constexpr basic_fraction<Int, N, O>& basic_fraction<Int, N, O>::operator += (const basic_fraction& rhs) { add(rhs.num, rhs.den); return *this; }
+template <class Int, class N, class O> constexpr basic_fraction<Int, N, O>& basic_fraction<Int, N, O>::operator -= (const basic_fraction& rhs) {
+	wide_type rhs_num = 0;
+	bool overflowed = checked_sub<wide_type>(0, rhs.num, rhs_num);
+	add(rhs_num, rhs.den, overflowed);
+	return *this;
+}
+template <class Int, class N, class O> constexpr basic_fraction<Int, N, O>& basic_fraction<Int, N, O>::operator *= (const basic_fraction& rhs) { multiply(rhs.num, rhs.den); return *this; }
+template <class Int, class N, class O> constexpr basic_fraction<Int, N, O>& basic_fraction<Int, N, O>::operator /= (const basic_fraction& rhs) { multiply(rhs.den, rhs.num); return *this; }
+
+template <class Int, class N, class O> constexpr basic_fraction<Int, N, O>& basic_fraction<Int, N, O>::operator  = (const Int &rhs) noexcept { num = rhs; den = 1; return *this; }
+template <class Int, class N, class O> constexpr basic_fraction<Int, N, O>& basic_fraction<Int, N, O>::operator *= (const Int &rhs) { multiply(rhs, 1); return *this; }
+template <class Int, class N, class O> constexpr basic_fraction<Int, N, O>& basic_fraction<Int, N, O>::operator /= (const Int &rhs) { multiply(1, rhs); return *this; }
+template <class Int, class N, class O> constexpr basic_fraction<Int, N, O>& basic_fraction<Int, N, O>::operator += (const Int &rhs) { *this += basic_fraction(rhs); return *this; }
+template <class Int, class N, class O> constexpr basic_fraction<Int, N, O>& basic_fraction<Int, N, O>::operator -= (const Int &rhs) { *this -= basic_fraction(rhs); return *this; }
+
+// Operator overloads : rhs arithmetic
 
-template <class T> fraction operator+ (const T& lhs, fraction rhs) { rhs += lhs; return rhs; }
-template <class T> fraction operator- (const T& lhs, fraction rhs) { rhs -= lhs; return rhs; }
-template <class T> fraction operator* (const T& lhs, fraction rhs) { rhs *= lhs; return rhs; }
-template <class T> fraction operator/ (const T& lhs, fraction rhs) { rhs /= lhs; return rhs; }
+template <class I, class N, class O, class T> constexpr basic_fraction<I, N, O> operator+ (basic_fraction<I, N, O> lhs, const T& rhs) { lhs += rhs; return lhs; }
+template <class I, class N, class O, class T> constexpr basic_fraction<I, N, O> operator- (basic_fraction<I, N, O> lhs, const T& rhs) { lhs -= rhs; return lhs; }
+template <class I, class N, class O, class T> constexpr basic_fraction<I, N, O> operator* (basic_fraction<I, N, O> lhs, const T& rhs) { lhs *= rhs; return lhs; }
+template <class I, class N, class O, class T> constexpr basic_fraction<I, N, O> operator/ (basic_fraction<I, N, O> lhs, const T& rhs) { lhs /= rhs; return lhs; }
 
-template <class T> fraction operator+ (fraction lhs, const fraction & rhs) { lhs += rhs; return lhs; }
-template <class T> fraction operator- (fraction lhs, const fraction & rhs) { lhs -= rhs; return lhs; }
-template <class T> fraction operator* (fraction lhs, const fraction & rhs) { lhs *= rhs; return lhs; }
-template <class T> fraction operator/ (fraction lhs, const fraction & rhs) { lhs /= rhs; return lhs; }
+template <class I, class N, class O, class T, class = typename std::enable_if<is_integer<T>::value>::type> constexpr basic_fraction<I, N, O> operator+ (const T& lhs, basic_fraction<I, N, O> rhs) { rhs += I(lhs); return rhs; }
+template <class I, class N, class O, class T, class = typename std::enable_if<is_integer<T>::value>::type> constexpr basic_fraction<I, N, O> operator- (const T& lhs, basic_fraction<I, N, O> rhs) { basic_fraction<I, N, O> result((I)lhs); result -= rhs; return result; }
+template <class I, class N, class O, class T, class = typename std::enable_if<is_integer<T>::value>::type> constexpr basic_fraction<I, N, O> operator* (const T& lhs, basic_fraction<I, N, O> rhs) { rhs *= I(lhs); return rhs; }
+template <class I, class N, class O, class T, class = typename std::enable_if<is_integer<T>::value>::type> constexpr basic_fraction<I, N, O> operator/ (const T& lhs, basic_fraction<I, N, O> rhs) { basic_fraction<I, N, O> result((I)lhs); result /= rhs; return result; }
 
-std::ostream& operator << (std::ostream& os, const fraction& rhs);
-std::istream& operator >> (std::istream& in, fraction& rhs);
+template <class I, class N, class O> std::ostream& operator << (std::ostream& os, const basic_fraction<I, N, O>& rhs) {
+	os << rhs.to_string();
+	return os;
+}
+template <class I, class N, class O> std::istream& operator >> (std::istream& in, basic_fraction<I, N, O>& rhs) {
+	// Read the characters a fraction can be made of, then parse them: the fraction must be "a/b" or "a".
+	// It is parsed into a temporary, so rhs is only changed if all of it parses (not to 3 for "3/").
+	char buffer[fraction_chars];
+	std::size_t size = 0;
+	std::istream::sentry skip_whitespace(in);
+	if (!skip_whitespace) return in;
+	for (int c = in.peek(); size < sizeof(buffer) && (c == '-' || c == '/' || (c >= '0' && c <= '9')); c = in.peek()) buffer[size++] = char(in.get());
 
+	basic_fraction<I, N, O> value;
+	std::from_chars_result result = from_chars(buffer, buffer + size, value);
+	if (result.ec != std::errc() || result.ptr != buffer + size) in.setstate(std::ios::failbit);
+	else rhs = value;
+	return in;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "big_fraction.h"
+#include "fraction.h"
+
+/*	An exact sum of many fractions, e.g. of 10^8 measured rationals.
+
+	Adding fractions one at a time multiplies their denominators at every step, so the terms soon overflow
+	(or, for big_fraction, need a gcd per addition). Instead the accumulator groups the terms by denominator,
+	and only adds numerators: n1/d + n2/d + ... = (n1 + n2 + ...)/d, in 128 bit integers. The groups are combined
+	with their least common multiple only when the sum is read, or when there are too many of them (or a group's
+	numerator would overflow), into an exact big_fraction. Terms are never normalised.
+
+	Accumulators of parts of a range can be merged, which parallel_reduce does with one accumulator per thread.
+
+	Example use:
+		fraction_accumulator sum;
+		for (int i = 1; i <= 1000; ++i) sum += fraction(1, i % 10 + 1);
+		sum.sum();						// 100 (1 + 1/2 + ... + 1/10) = 36905/126, exactly
+		parallel_reduce(v.begin(), v.end()).to_double();
+
+	Takes fractions with terms of up to 64 bits; wider terms go straight into the big_fraction total.
+	Implementation of the combining (slow) paths is in fraction_accumulator.cpp.
+*/
+class fraction_accumulator
+{
+public:
+#if HAS_INT128
+	typedef int128_t sum_type;
+#else
+	typedef std::int64_t sum_type;
+#endif
+
+private:
+	struct group { std::int64_t den; sum_type num; };		// den == 0 marks an empty slot
+
+	std::vector<group> slots;		// open addressing hash table of the groups, keyed by denominator
+	std::size_t count;				// number of groups in use
+	std::size_t last;				// slot of the last denominator added, as equal denominators often come in runs
+	big_fraction total;				// the groups combined so far
+
+	static const std::size_t initial_slots = 64;
+	static const std::size_t max_slots = 4096;		// at most half full: then the groups are combined into total
+
+	static std::size_t hash(std::int64_t den, std::size_t size) noexcept { return std::size_t((std::uint64_t(den) * 0x9E3779B97F4A7C15ull) >> 32) & (size - 1); }
+	std::size_t find(std::int64_t den);				// the slot of den's group, making one (and growing the table) if needed
+	void rehash(std::size_t size);
+	void flush();									// combine every group into total
+	void add_slow(std::int64_t num, std::int64_t den);
+	void add_group(std::int64_t den, sum_type num);		// den > 0
+
+public:
+
+	// Construction
+
+	fraction_accumulator() : slots(initial_slots), count(0), last(0), total() {}
+
+	// Functions
+
+	void add(std::int64_t num, std::int64_t den);
+	template <class I> void add(const I* nums, const I* dens, std::size_t n) { static_assert(sizeof(I) <= sizeof(std::int64_t), "terms of up to 64 bits"); for (std::size_t i = 0; i < n; ++i) add(std::int64_t(nums[i]), std::int64_t(dens[i])); }
+	template <class It, class = typename std::enable_if<!is_integer<It>::value>::type> void add(It first, It last) { for (; first != last; ++first) *this += *first; }
+	void merge(const fraction_accumulator& rhs);
+	void clear();
+
+	std::size_t groups() const noexcept { return count; }		// number of distinct denominators not yet combined
+	big_fraction sum() const;									// the exact sum
+	double to_double() const { return sum().to_double(); }
+
+	// Operator overloads
+
+	template <class I, class N, class O> fraction_accumulator& operator += (const basic_fraction<I, N, O>& f)
+	{
+		if constexpr (sizeof(I) <= sizeof(std::int64_t)) add(std::int64_t(f.get_num()), std::int64_t(f.get_den()));
+		else total += big_fraction(f);
+		return *this;
+	}
+	fraction_accumulator& operator += (const big_fraction& f) { total += f; return *this; }
+	fraction_accumulator& operator += (const fraction_accumulator& rhs) { merge(rhs); return *this; }
+};
+
+// Inline fast path
+
+inline void fraction_accumulator::add(std::int64_t num, std::int64_t den)
+{
+	if (den > 0) {
+		std::size_t i = last;
+		const std::size_t mask = slots.size() - 1;
+		if (slots[i].den != den) for (i = hash(den, slots.size()); slots[i].den != den && slots[i].den != 0; i = (i + 1) & mask) {}
+
+		group& g = slots[i];
+		sum_type n = 0;
+		if (g.den == den && !checked_add(g.num, sum_type(num), n)) { g.num = n; last = i; return; }
+	}
+	add_slow(num, den);		// a new denominator, a numerator overflow, or a denominator that is not positive
+}
+
+// Sum the fractions in [first, last) with one accumulator per thread (threads = 0 for one per core), then merge them.
+// It must be a random access iterator. Exceptions from the threads (e.g. a zero denominator) are rethrown.
+template <class It> fraction_accumulator parallel_reduce(It first, It last, unsigned threads = 0)
+{
+	const std::size_t min_chunk = 1 << 16;		// smaller ranges are not worth starting a thread for
+	std::size_t n = std::size_t(std::distance(first, last));
+	if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+	threads = unsigned(std::min<std::size_t>(threads, n / min_chunk + 1));
+
+	std::vector<fraction_accumulator> partial(threads);
+	std::vector<std::exception_ptr> errors(threads);
+	auto work = [&](unsigned t) {
+		try { partial[t].add(first + n * t / threads, first + n * (t + 1) / threads); }
+		catch (...) { errors[t] = std::current_exception(); }
+	};
+
+	std::vector<std::thread> workers;
+	for (unsigned t = 1; t < threads; ++t) workers.emplace_back(work, t);
+	work(0);
+	for (std::thread& w : workers) w.join();
+
+	for (unsigned t = 0; t < threads; ++t) if (errors[t]) std::rethrow_exception(errors[t]);
+	for (unsigned t = 1; t < threads; ++t) partial[0].merge(partial[t]);
+	return std::move(partial[0]);
+}
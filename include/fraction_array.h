@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "fraction.h"
+#include "simd.h"
+
+// Batch kernels for fractions of int
+//		Each works elementwise on arrays of numerators and denominators, and gives exactly the same
+//		result as the scalar basic_fraction<int, no_normalize, overflow_wrap> operator (i.e. fraction, unless
+//		AUTO_SIMPLIFY is set). Outputs may alias the inputs. compare, to_double and simplify are the same
+//		for every normalisation and overflow policy, so work for any basic_fraction<int, ...>.
+//
+//		get() returns the kernels for the best instruction set of this CPU (see simd.h), or those for a given
+//		instruction set, e.g. to check results against the scalar kernels. Implementation in fraction_array.cpp.
+//------------------------------------------------------------------------------------
+
+struct fraction_kernels
+{
+	typedef void (*binary_op)(const int* lhs_num, const int* lhs_den, const int* rhs_num, const int* rhs_den, int* out_num, int* out_den, std::size_t n);
+
+	binary_op add, sub, mul, div;
+	void (*compare)(const int* lhs_num, const int* lhs_den, const int* rhs_num, const int* rhs_den, std::int8_t* out, std::size_t n);	// the sign of lhs - rhs
+	void (*to_double)(const int* num, const int* den, double* out, std::size_t n);
+	void (*simplify)(int* num, int* den, std::size_t n);
+
+	static const fraction_kernels& get(simd_isa isa = active_isa());
+};
+
+//	An array of fractions, stored as an array of numerators and an array of denominators (structure of arrays),
+//	so that batches of fractions can be processed with SIMD instructions.
+//		F	: the basic_fraction type of the elements.
+//
+//	The batch operators act elementwise, and give exactly the same result as F's scalar operators.
+//	For fractions of int they use the vectorised kernels above (AVX2 or AVX-512 where available),
+//	otherwise they fall back to a loop over F. Both arrays must be the same size (or std::length_error is thrown).
+//
+//	Example use:
+//		fraction_array a, b;
+//		a.push_back(fraction(1, 2)); b.push_back(fraction(1, 3));
+//		a += b;						// a[0] = 5/6
+//		a.to_double(values);		// values[0] = 0.8333...
+//		a.compare(b, signs);		// signs[0] = 1, as 5/6 > 1/3
+template <class F>
+class basic_fraction_array
+{
+public:
+	typedef F value_type;
+	typedef typename F::int_type Int;
+	typedef std::vector<Int, aligned_allocator<Int> > storage;
+
+private:
+	storage nums, dens;
+
+	static const bool int_kernels  = std::is_same<Int, int>::value;		// compare, to_double and simplify
+	static const bool wrap_kernels = int_kernels && !F::normalize_policy::enabled && std::is_same<typename F::overflow_policy, overflow_wrap>::value;
+
+	void check_size(const basic_fraction_array& rhs) const { if (rhs.size() != size()) throw std::length_error("fraction_array sizes differ"); }
+	template <class Op> basic_fraction_array& apply(const basic_fraction_array& rhs, fraction_kernels::binary_op kernel, Op op);
+
+public:
+
+	// Construction
+
+	basic_fraction_array() {}
+	explicit basic_fraction_array(std::size_t n, const F& value = F(0)) : nums(n, value.get_num()), dens(n, value.get_den()) {}
+	template <class It> basic_fraction_array(It first, It last) { for (; first != last; ++first) push_back(*first); }
+
+	// Accessors
+
+	std::size_t size() const noexcept { return nums.size(); }
+	bool empty() const noexcept { return nums.empty(); }
+	void reserve(std::size_t n) { nums.reserve(n); dens.reserve(n); }
+	void resize(std::size_t n, const F& value = F(0)) { nums.resize(n, value.get_num()); dens.resize(n, value.get_den()); }
+	void clear() noexcept { nums.clear(); dens.clear(); }
+	void push_back(const F& f) { nums.push_back(f.get_num()); dens.push_back(f.get_den()); }
+
+	F    get(std::size_t i) const { return F(nums[i], dens[i]); }
+	void set(std::size_t i, const F& f) { nums[i] = f.get_num(); dens[i] = f.get_den(); }
+	F    operator [] (std::size_t i) const { return get(i); }
+
+	      Int* num_data() noexcept { return nums.data(); }		// aligned to simd_alignment
+	const Int* num_data() const noexcept { return nums.data(); }
+	      Int* den_data() noexcept { return dens.data(); }
+	const Int* den_data() const noexcept { return dens.data(); }
+
+	// Batch functions
+
+	basic_fraction_array& simplify();
+	void compare(const basic_fraction_array& rhs, std::int8_t* out) const;		// out[i] = sign of (*this)[i] - rhs[i]
+	void to_double(double* out) const;
+	std::vector<double> to_double() const { std::vector<double> out(size()); to_double(out.data()); return out; }
+
+	// Batch operator overloads
+
+	basic_fraction_array& operator += (const basic_fraction_array& rhs);
+	basic_fraction_array& operator -= (const basic_fraction_array& rhs);
+	basic_fraction_array& operator *= (const basic_fraction_array& rhs);
+	basic_fraction_array& operator /= (const basic_fraction_array& rhs);
+};
+
+typedef basic_fraction_array<fraction> fraction_array;
+
+// Batch functions
+
+template <class F> template <class Op>
+basic_fraction_array<F>& basic_fraction_array<F>::apply(const basic_fraction_array& rhs, fraction_kernels::binary_op kernel, Op op)
+{
+	check_size(rhs);
+	if constexpr (wrap_kernels) kernel(nums.data(), dens.data(), rhs.nums.data(), rhs.dens.data(), nums.data(), dens.data(), size());
+	else {
+		for (std::size_t i = 0; i < size(); ++i) {
+			F f = get(i);
+			op(f, rhs.get(i));
+			set(i, f);
+		}
+	}
+	return *this;
+}
+
+template <class F> basic_fraction_array<F>& basic_fraction_array<F>::simplify()
+{
+	if constexpr (int_kernels) fraction_kernels::get().simplify(nums.data(), dens.data(), size());
+	else for (std::size_t i = 0; i < size(); ++i) set(i, get(i).simplify());
+	return *this;
+}
+
+template <class F> void basic_fraction_array<F>::compare(const basic_fraction_array& rhs, std::int8_t* out) const
+{
+	check_size(rhs);
+	if constexpr (int_kernels) fraction_kernels::get().compare(nums.data(), dens.data(), rhs.nums.data(), rhs.dens.data(), out, size());
+	else for (std::size_t i = 0; i < size(); ++i) out[i] = std::int8_t(get(i) < rhs.get(i) ? -1 : (rhs.get(i) < get(i) ? 1 : 0));
+}
+
+template <class F> void basic_fraction_array<F>::to_double(double* out) const
+{
+	if constexpr (int_kernels) fraction_kernels::get().to_double(nums.data(), dens.data(), out, size());
+	else for (std::size_t i = 0; i < size(); ++i) out[i] = get(i).to_double();
+}
+
+// Batch operator overloads
+
+template <class F> basic_fraction_array<F>& basic_fraction_array<F>::operator += (const basic_fraction_array& rhs) { return apply(rhs, fraction_kernels::get().add, [](F& a, const F& b) { a += b; }); }
+template <class F> basic_fraction_array<F>& basic_fraction_array<F>::operator -= (const basic_fraction_array& rhs) { return apply(rhs, fraction_kernels::get().sub, [](F& a, const F& b) { a -= b; }); }
+template <class F> basic_fraction_array<F>& basic_fraction_array<F>::operator *= (const basic_fraction_array& rhs) { return apply(rhs, fraction_kernels::get().mul, [](F& a, const F& b) { a *= b; }); }
+template <class F> basic_fraction_array<F>& basic_fraction_array<F>::operator /= (const basic_fraction_array& rhs) { return apply(rhs, fraction_kernels::get().div, [](F& a, const F& b) { a /= b; }); }
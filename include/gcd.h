@@ -0,0 +1,155 @@
+#pragma once
+
+/*	Greatest common divisor and lowest common multiple of integers, and exact integer roots.
+
+	gcd uses the binary (Stein's) algorithm: common factors of two are removed with a single
+	count-trailing-zeros, and the remaining odd parts are reduced by subtraction and shifting,
+	so no division is ever performed. This is several times quicker than Euclid's algorithm
+	on most hardware, where integer division is slow.
+
+	Example use:
+		gcd(12, 18);	// 6
+		lcm(4, 6);		// 12
+		exact_root(27u, 3, r);	// true, r = 3
+*/
+
+#include <cstdint>
+#include <type_traits>
+#include "int_traits.h"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+	#include <intrin.h>
+#endif
+
+// Count trailing zeros
+//------------------------------------------------------------------------------------
+//		Number of zero bits below the least significant 1 bit, e.g. ctz(12) = ctz(1100) = 2.
+//		The result is undefined for x = 0. Usable in constant expressions (MSVC needs C++20 for that).
+
+constexpr int ctz(std::uint32_t x) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctz(x);
+#else
+	#if defined(_MSC_VER)
+		#if defined(__cpp_lib_is_constant_evaluated)
+		if (!std::is_constant_evaluated())
+		#endif
+		{
+			unsigned long index;
+			_BitScanForward(&index, x);
+			return (int)index;
+		}
+	#endif
+	int n = 0;
+	while ((x & 1) == 0) { x >>= 1; ++n; }
+	return n;
+#endif
+}
+
+constexpr int ctz(std::uint64_t x) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(x);
+#else
+	#if defined(_MSC_VER) && defined(_WIN64)
+		#if defined(__cpp_lib_is_constant_evaluated)
+		if (!std::is_constant_evaluated())
+		#endif
+		{
+			unsigned long index;
+			_BitScanForward64(&index, x);
+			return (int)index;
+		}
+	#endif
+	std::uint32_t low = (std::uint32_t)x;
+	return low ? ctz(low) : 32 + ctz((std::uint32_t)(x >> 32));
+#endif
+}
+
+#if HAS_INT128
+constexpr int ctz(uint128_t x) noexcept
+{
+	std::uint64_t low = (std::uint64_t)x;
+	return low ? ctz(low) : 64 + ctz((std::uint64_t)(x >> 64));
+}
+#endif
+
+// Greatest common divisor
+//------------------------------------------------------------------------------------
+
+// Return the greatest common divisor of the magnitudes of a and b (always non-negative).
+// gcd(0, b) = |b| and gcd(0, 0) = 0.
+template <class Int> constexpr Int gcd(Int a, Int b) noexcept
+{
+	static_assert(is_integer<Int>::value, "gcd requires an integer type");
+	typedef typename unsigned_of<Int>::type U;
+	typedef typename std::conditional<(sizeof(U) <= sizeof(std::uint32_t)), std::uint32_t,
+			typename std::conditional<(sizeof(U) <= sizeof(std::uint64_t)), std::uint64_t, U>::type>::type W;
+
+	// Work on unsigned magnitudes, so that the most negative value is handled correctly.
+	W u = a < 0 ? W(U(0) - U(a)) : W(a);
+	W v = b < 0 ? W(U(0) - U(b)) : W(b);
+
+	if (u == 0) return Int(v);
+	if (v == 0) return Int(u);
+
+	int shift = ctz(u | v);		// the power of two common to both
+	u >>= ctz(u);
+
+	do {
+		v >>= ctz(v);			// u and v are both odd from here on
+		if (u > v) { W t = u; u = v; v = t; }
+		v -= u;					// even, and strictly smaller than before
+	} while (v != 0);
+
+	return Int(u << shift);
+}
+
+// Return the lowest common multiple of the magnitudes of a and b (lcm(0, b) = 0).
+// Divides before multiplying, so only overflows if the result itself does not fit in Int.
+template <class Int> constexpr Int lcm(Int a, Int b) noexcept
+{
+	if (a == 0 || b == 0) return Int(0);
+	Int g = gcd(a, b);
+	Int result = (a / g) * b;
+	return result < 0 ? -result : result;
+}
+
+// Integer roots
+//------------------------------------------------------------------------------------
+
+// Return true if m is an exact q-th power (q >= 1), and set root to its q-th root, e.g. exact_root(32u, 5, r) sets r = 2.
+// The root is found bit by bit from the top (it has at most bits(m) / q bits), so no floating point is involved.
+template <class U> constexpr bool exact_root(U m, unsigned q, U& root) noexcept
+{
+	static_assert(is_integer<U>::value && U(-1) > U(0), "exact_root requires an unsigned integer type");
+
+	// Return true if r^q <= m, without overflowing: x * r <= m exactly when x <= m / r.
+	auto at_most = [m, q](U r) {
+		U x = 1;
+		for (unsigned i = 0; i < q; ++i) {
+			if (r != 0 && x > m / r) return false;
+			x *= r;
+		}
+		return true;
+	};
+
+	if (q == 0) return false;
+	if (q == 1 || m < 2) { root = m; return true; }
+
+	int bits = 0;
+	for (U x = m; x != 0; x >>= 1) ++bits;
+	if (q >= unsigned(bits)) return false;		// 1 < m < 2^q, so lies strictly between 1^q and 2^q
+
+	// Find the largest r with r^q <= m.
+	U r = 0;
+	for (int bit = (bits + int(q) - 1) / int(q); bit-- > 0;)
+		if (at_most(r | (U(1) << bit))) r |= U(1) << bit;
+
+	U x = 1;
+	for (unsigned i = 0; i < q; ++i) x *= r;		// cannot overflow, as r^q <= m
+	if (x != m) return false;
+	root = r;
+	return true;
+}
@@ -0,0 +1,256 @@
+#pragma once
+
+/*	Traits and helpers for writing code that is generic over the built-in signed integers,
+	including the 128 bit integer provided by GCC and Clang (which the standard type traits
+	do not recognise outside of gnu++ modes).
+
+		is_integer<T>		: true for all built-in integers (and __int128 where available).
+		unsigned_of<T>		: the unsigned integer of the same width.
+		wider<T>			: the next signed integer up, used for overflow-free intermediates,
+							  e.g. the product of two int32_t always fits in an int64_t.
+							  The widest integer is its own wider type (has_wider<T> is then false).
+		checked_add/sub/mul	: two's complement (wrapping) arithmetic that also reports overflow.
+		int_to_string		: std::to_string, extended to 128 bit integers.
+		mul_full, uint256	: double-width and 256 bit unsigned products, for exact comparisons.
+*/
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#if defined(__SIZEOF_INT128__)
+	#define HAS_INT128 1
+	__extension__ typedef __int128 int128_t;
+	__extension__ typedef unsigned __int128 uint128_t;
+#else
+	#define HAS_INT128 0
+#endif
+
+// Traits
+//------------------------------------------------------------------------------------
+
+template <class T> struct is_integer : std::is_integral<T> {};
+template <class T> struct unsigned_of : std::make_unsigned<T> {};
+template <class T> struct int_limits
+{
+	static constexpr T min() noexcept { return std::numeric_limits<T>::min(); }
+	static constexpr T max() noexcept { return std::numeric_limits<T>::max(); }
+	static constexpr int digits = std::numeric_limits<T>::digits;
+};
+
+#if HAS_INT128
+template <> struct is_integer<int128_t>  : std::true_type {};
+template <> struct is_integer<uint128_t> : std::true_type {};
+template <> struct unsigned_of<int128_t>  { typedef uint128_t type; };
+template <> struct unsigned_of<uint128_t> { typedef uint128_t type; };
+template <> struct int_limits<int128_t>
+{
+	static constexpr int128_t max() noexcept { return int128_t(~uint128_t(0) >> 1); }
+	static constexpr int128_t min() noexcept { return -max() - 1; }
+	static constexpr int digits = 127;
+};
+template <> struct int_limits<uint128_t>
+{
+	static constexpr uint128_t min() noexcept { return 0; }
+	static constexpr uint128_t max() noexcept { return ~uint128_t(0); }
+	static constexpr int digits = 128;
+};
+#endif
+
+template <class T> struct wider { typedef T type; };
+template <> struct wider<std::int8_t>  { typedef std::int16_t type; };
+template <> struct wider<std::int16_t> { typedef std::int32_t type; };
+template <> struct wider<std::int32_t> { typedef std::int64_t type; };
+#if HAS_INT128
+template <> struct wider<std::int64_t> { typedef int128_t type; };
+#endif
+
+template <class T> struct has_wider : std::integral_constant<bool, !std::is_same<typename wider<T>::type, T>::value> {};
+
+// Return true if the integer x can be represented by the signed integer type To.
+template <class To, class From> constexpr bool fits(From x) noexcept
+{
+	if constexpr (From(-1) > From(0)) return x <= typename unsigned_of<To>::type(int_limits<To>::max());
+	else if constexpr (sizeof(To) >= sizeof(From)) return true;
+	else return x >= From(int_limits<To>::min()) && x <= From(int_limits<To>::max());
+}
+
+// Checked (wrapping) arithmetic
+//------------------------------------------------------------------------------------
+//		result is always the two's complement wrapped value, and the return value is true
+//		if the true result did not fit.
+
+template <class T> constexpr bool checked_add(T a, T b, T& result) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_add_overflow(a, b, &result);
+#else
+	typedef typename unsigned_of<T>::type U;
+	result = T(U(a) + U(b));
+	return ((a ^ result) & (b ^ result)) < 0;
+#endif
+}
+
+template <class T> constexpr bool checked_sub(T a, T b, T& result) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_sub_overflow(a, b, &result);
+#else
+	typedef typename unsigned_of<T>::type U;
+	result = T(U(a) - U(b));
+	return ((a ^ b) & (a ^ result)) < 0;
+#endif
+}
+
+template <class T> constexpr bool checked_mul(T a, T b, T& result) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_mul_overflow(a, b, &result);
+#else
+	typedef typename unsigned_of<T>::type U;
+	result = T(U(a) * U(b));
+	if (a == 0 || b == 0) return false;
+	if ((a == -1 && b == int_limits<T>::min()) || (b == -1 && a == int_limits<T>::min())) return true;
+	return result / b != a;
+#endif
+}
+
+// Strings
+//------------------------------------------------------------------------------------
+
+// Parse an optional '-' and decimal digits from [first, last), like std::from_chars.
+// value is only written on success; ec is invalid_argument if there are no digits, or result_out_of_range if they do not fit in T.
+template <class T> std::from_chars_result int_from_chars(const char* first, const char* last, T& value) noexcept
+{
+	if constexpr (sizeof(T) <= sizeof(long long)) return std::from_chars(first, last, value);
+	else {
+		typedef typename unsigned_of<T>::type U;
+		const char* p = first;
+		bool negative = T(-1) < T(0) && p != last && *p == '-';
+		if (negative) ++p;
+		const char* digits = p;
+		const U limit = negative ? U(0) - U(int_limits<T>::min()) : U(int_limits<T>::max());
+		U magnitude = 0;
+		bool overflowed = false;
+		for (; p != last && unsigned(*p - '0') < 10; ++p) {
+			unsigned digit = unsigned(*p - '0');
+			if (magnitude > (limit - digit) / 10) overflowed = true;
+			else magnitude = magnitude * 10 + digit;
+		}
+		if (p == digits) return { first, std::errc::invalid_argument };
+		if (overflowed) return { p, std::errc::result_out_of_range };
+		value = negative ? T(U(0) - magnitude) : T(magnitude);
+		return { p, std::errc() };
+	}
+}
+
+// Write x in decimal to [first, last), like std::to_chars. ec is value_too_large if it does not fit.
+template <class T> std::to_chars_result int_to_chars(char* first, char* last, T x) noexcept
+{
+	if constexpr (sizeof(T) <= sizeof(long long)) return std::to_chars(first, last, x);
+	else {
+		typedef typename unsigned_of<T>::type U;
+		U magnitude = x < 0 ? U(0) - U(x) : U(x);
+		char buffer[48];
+		char* p = buffer + sizeof(buffer);
+		do {
+			*--p = char('0' + int(magnitude % 10));
+			magnitude /= 10;
+		} while (magnitude != 0);
+		if (x < 0) *--p = '-';
+
+		std::size_t size = std::size_t(buffer + sizeof(buffer) - p);
+		if (std::size_t(last - first) < size) return { last, std::errc::value_too_large };
+		std::memcpy(first, p, size);
+		return { first + size, std::errc() };
+	}
+}
+
+template <class T> std::string int_to_string(T x)
+{
+	char buffer[48];
+	return std::string(buffer, int_to_chars(buffer, buffer + sizeof(buffer), x).ptr);
+}
+
+// Full width multiplication
+//------------------------------------------------------------------------------------
+
+// Multiply two unsigned integers into a result twice as wide, returned as (high, low) halves.
+// Used where there is no wider built-in type to hold the product.
+template <class U> constexpr void mul_full(U a, U b, U& high, U& low) noexcept
+{
+	const int half = int_limits<U>::digits / 2;
+	const U mask = (U(1) << half) - 1;
+
+	U a0 = a & mask, a1 = a >> half;
+	U b0 = b & mask, b1 = b >> half;
+
+	U p00 = a0 * b0, p01 = a0 * b1;
+	U p10 = a1 * b0, p11 = a1 * b1;
+
+	U middle = (p00 >> half) + (p01 & mask) + (p10 & mask);		// cannot overflow: at most 3 * (2^half - 1)
+	low  = (middle << half) | (p00 & mask);
+	high = p11 + (p01 >> half) + (p10 >> half) + (middle >> half);
+}
+
+// A fixed 256 bit unsigned integer, for exact intermediate results that are too wide even for mul_full,
+// e.g. comparing a 128 bit fraction with a floating point value. Only the few operations needed are provided.
+struct uint256
+{
+	std::uint64_t limb[4] = {};		// least significant first
+
+	uint256() noexcept {}
+	template <class U> explicit uint256(U x) noexcept
+	{
+		static_assert(sizeof(U) <= 16, "uint256 is built from integers of up to 128 bits");
+		limb[0] = std::uint64_t(x);
+		if constexpr (sizeof(U) > 8) limb[1] = std::uint64_t(x >> 64);
+	}
+
+	// *this *= m. The result must fit in 256 bits.
+	void multiply(std::uint64_t m) noexcept
+	{
+		std::uint64_t carry = 0;
+		for (std::uint64_t& l : limb) {
+			std::uint64_t high = 0, low = 0;
+			mul_full(l, m, high, low);
+			l = low + carry;
+			carry = high + (l < low);
+		}
+	}
+
+	// *this <<= s, for 0 <= s < 256. The result must fit in 256 bits.
+	void shift_left(int s) noexcept
+	{
+		int words = s / 64, bits = s % 64;
+		for (int i = 3; i >= 0; --i) {
+			std::uint64_t l = i >= words ? limb[i - words] : 0;
+			std::uint64_t below = i > words ? limb[i - words - 1] : 0;
+			limb[i] = bits ? (l << bits) | (below >> (64 - bits)) : l;
+		}
+	}
+
+	// The number of significant bits, 0 for zero.
+	int bits() const noexcept
+	{
+		for (int i = 3; i >= 0; --i) {
+			if (limb[i] == 0) continue;
+			std::uint64_t x = limb[i];
+			int n = 1;
+			for (int s = 32; s > 0; s /= 2) if (x >> s) { x >>= s; n += s; }
+			return i * 64 + n;
+		}
+		return 0;
+	}
+
+	// The sign of *this - rhs.
+	int compare(const uint256& rhs) const noexcept
+	{
+		for (int i = 3; i >= 0; --i) if (limb[i] != rhs.limb[i]) return limb[i] > rhs.limb[i] ? 1 : -1;
+		return 0;
+	}
+};
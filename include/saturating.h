@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include "int_traits.h"
+#include "simd.h"
+
+/*	Saturating integer arithmetic: results that overflow stop at the limits of the type, rather than wrapping around
+	(e.g. for int8_t, 100 + 100 = 127 and -100 - 100 = -128; for uint8_t, 200 + 100 = 255 and 5 - 10 = 0).
+
+		saturate_add/sub/mul/div/neg	: the scalar operations, which detect overflow with the compiler's checked arithmetic
+										  (__builtin_add_overflow and so on, see checked_add in int_traits.h), so they are exact.
+		saturating<T>					: an integer whose operators saturate, for int8_t up to int64_t and the unsigned types.
+										  The same as a static_bound<T, min of T, max of T, bound_saturate>, which uses these.
+		saturating_kernels<T>			: elementwise add and sub of arrays, with the CPU's saturating instructions
+										  (vpaddsb, vpaddusb, vpaddsw, vpaddusw) for 8 and 16 bit types, and overflow masks
+										  for 32 and 64 bit types, which have none. Implementation in saturating.cpp.
+*/
+
+// Scalar functions
+//------------------------------------------------------------------------------------
+
+template <class T> constexpr bool is_negative(T x) noexcept { if constexpr (T(-1) < T(0)) return x < T(0); else return false; }
+
+template <class T> constexpr T saturate_add(T a, T b) noexcept
+{
+	T result = 0;
+	if (checked_add(a, b, result)) return is_negative(b) ? int_limits<T>::min() : int_limits<T>::max();
+	return result;
+}
+
+template <class T> constexpr T saturate_sub(T a, T b) noexcept
+{
+	T result = 0;
+	if (checked_sub(a, b, result)) return is_negative(b) ? int_limits<T>::max() : int_limits<T>::min();
+	return result;
+}
+
+template <class T> constexpr T saturate_mul(T a, T b) noexcept
+{
+	T result = 0;
+	if (checked_mul(a, b, result)) return is_negative(a) != is_negative(b) ? int_limits<T>::min() : int_limits<T>::max();
+	return result;
+}
+
+// Only the division of the most negative value by -1 can overflow. b must not be 0.
+template <class T> constexpr T saturate_div(T a, T b) noexcept
+{
+	if constexpr (T(-1) < T(0)) { if (a == int_limits<T>::min() && b == T(-1)) return int_limits<T>::max(); }
+	return T(a / b);
+}
+
+template <class T> constexpr T saturate_neg(T a) noexcept { return saturate_sub(T(0), a); }
+
+// x converted to T, clamped to the limits of T
+template <class T, class I> constexpr T saturate_cast(I x) noexcept
+{
+	if (fits<T>(x)) return T(x);
+	return is_negative(x) ? int_limits<T>::min() : int_limits<T>::max();
+}
+
+// Saturating integers
+//------------------------------------------------------------------------------------
+
+template <class T>
+class saturating {
+	static_assert(is_integer<T>::value, "saturating requires an integer type");
+
+	T val;
+
+public:
+	typedef T value_type;
+
+	// Construction
+
+	constexpr saturating() noexcept : val(0) {}
+	constexpr saturating(T val) noexcept : val(val) {}
+	template <class I> static constexpr saturating from(I x) noexcept { return saturating(saturate_cast<T>(x)); }		// from any integer, clamped
+
+	static constexpr saturating min() noexcept { return saturating(int_limits<T>::min()); }
+	static constexpr saturating max() noexcept { return saturating(int_limits<T>::max()); }
+
+	// Accessors
+
+	constexpr T get() const noexcept { return val; }
+	constexpr bool saturated() const noexcept { return val == int_limits<T>::min() || val == int_limits<T>::max(); }		// at either limit
+
+	// Type casts
+
+	constexpr operator T() const noexcept { return val; }
+	std::string to_string() const { return std::to_string(val); }
+
+	// Operator overloads
+
+	constexpr saturating operator-() const noexcept { return saturating(saturate_neg(val)); }
+
+	constexpr saturating& operator += (const saturating& rhs) noexcept { val = saturate_add(val, rhs.val); return *this; }
+	constexpr saturating& operator -= (const saturating& rhs) noexcept { val = saturate_sub(val, rhs.val); return *this; }
+	constexpr saturating& operator *= (const saturating& rhs) noexcept { val = saturate_mul(val, rhs.val); return *this; }
+	constexpr saturating& operator /= (const saturating& rhs) noexcept { val = saturate_div(val, rhs.val); return *this; }
+
+	constexpr saturating& operator++() noexcept { val = saturate_add(val, T(1)); return *this; }
+	constexpr saturating& operator--() noexcept { val = saturate_sub(val, T(1)); return *this; }
+	constexpr saturating operator++(int) noexcept { saturating result(*this); ++(*this); return result; }
+	constexpr saturating operator--(int) noexcept { saturating result(*this); --(*this); return result; }
+};
+
+// Operator overloads : rhs arithmetic
+
+template <class T> constexpr saturating<T> operator+ (saturating<T> lhs, const saturating<T>& rhs) noexcept { lhs += rhs; return lhs; }
+template <class T> constexpr saturating<T> operator- (saturating<T> lhs, const saturating<T>& rhs) noexcept { lhs -= rhs; return lhs; }
+template <class T> constexpr saturating<T> operator* (saturating<T> lhs, const saturating<T>& rhs) noexcept { lhs *= rhs; return lhs; }
+template <class T> constexpr saturating<T> operator/ (saturating<T> lhs, const saturating<T>& rhs) noexcept { lhs /= rhs; return lhs; }
+
+template <class T> std::ostream& operator << (std::ostream& os, const saturating<T>& rhs) { os << +rhs.get(); return os; }		// + prints 8 bit types as numbers
+
+typedef saturating<std::int8_t>   sat_int8;
+typedef saturating<std::int16_t>  sat_int16;
+typedef saturating<std::int32_t>  sat_int32;
+typedef saturating<std::int64_t>  sat_int64;
+typedef saturating<std::uint8_t>  sat_uint8;
+typedef saturating<std::uint16_t> sat_uint16;
+typedef saturating<std::uint32_t> sat_uint32;
+typedef saturating<std::uint64_t> sat_uint64;
+
+// Batch kernels
+//------------------------------------------------------------------------------------
+//		out[i] = saturate_add(lhs[i], rhs[i]), or saturate_sub. out may alias lhs or rhs.
+//		get() returns the kernels for the best instruction set of this CPU (see simd.h), or those for a given instruction set.
+//		Provided for the 8, 16, 32 and 64 bit signed and unsigned integers.
+
+template <class T>
+struct saturating_kernels
+{
+	typedef void (*binary_op)(const T* lhs, const T* rhs, T* out, std::size_t n);
+
+	binary_op add, sub;
+
+	static const saturating_kernels& get(simd_isa isa = active_isa());
+};
+
+template <> const saturating_kernels<std::int8_t>&   saturating_kernels<std::int8_t>::get(simd_isa isa);
+template <> const saturating_kernels<std::int16_t>&  saturating_kernels<std::int16_t>::get(simd_isa isa);
+template <> const saturating_kernels<std::int32_t>&  saturating_kernels<std::int32_t>::get(simd_isa isa);
+template <> const saturating_kernels<std::int64_t>&  saturating_kernels<std::int64_t>::get(simd_isa isa);
+template <> const saturating_kernels<std::uint8_t>&  saturating_kernels<std::uint8_t>::get(simd_isa isa);
+template <> const saturating_kernels<std::uint16_t>& saturating_kernels<std::uint16_t>::get(simd_isa isa);
+template <> const saturating_kernels<std::uint32_t>& saturating_kernels<std::uint32_t>::get(simd_isa isa);
+template <> const saturating_kernels<std::uint64_t>& saturating_kernels<std::uint64_t>::get(simd_isa isa);
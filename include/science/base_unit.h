@@ -5,34 +5,75 @@
 //		- add swap, copy and move functions/constructors
 //		- add std library overloads
 
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
 #include "fraction.h"
 #include "macros.h"
 #include "typedefs.h"
 
+typedef std::uint32_t symbol_id;
+
+//	The symbols of the base units ("kg", "m", "eV", ...), each interned once and numbered by a symbol_id,
+//	so that base units compare and copy their ids rather than strings. Id 0 is the empty symbol.
+//	Symbols are never removed. Interning and lookup are thread safe: a symbol that is already known
+//	only takes a shared lock, and the names keep their addresses, so a reference to one stays valid.
+//
+//	Ids depend on the order symbols are first seen, so anything that must be reproducible (the canonical order
+//	of a unit, its hash and so its printed form) uses before() and stable_hash() instead: the SI units and the
+//	common derived units are given fixed ids first, in a set order, and any other symbol is ordered by its name.
+class symbol_registry {
+	std::deque<str> names;								// by id
+	std::unordered_map<str, symbol_id> ids;				// by name, for interning
+	mutable std::shared_mutex mutex;
+
+	symbol_registry();
+
+public:
+	symbol_registry(const symbol_registry&) = delete;
+	symbol_registry& operator = (const symbol_registry&) = delete;
+
+	static symbol_registry& instance();
+
+	symbol_id intern(const str &name);					// adding it if it is new. Throws std::length_error if the ids run out.
+	const str& name(symbol_id id) const;				// throws std::out_of_range for an unknown id
+	std::size_t size() const;
+
+	static const symbol_id fixed;						// ids below this are pre-assigned, the same in every run
+	bool before(symbol_id a, symbol_id b) const;		// the fixed symbols in their set order, then the others by name
+	std::uint64_t stable_hash(symbol_id id) const;		// the id of a fixed symbol, or a hash of the name
+};
 
 //	A single base unit and it's power, e.g. kg^5
+//	Stored as the id of its symbol (see symbol_registry) and the power, so it is trivially copyable
+//	and compares as integers. The symbol's name is only looked up for printing, or by get_unit().
 //
 //	Addition/Subtraction	:	do nothing to unit, although in Debug mode it will check for unit
 //								homogenity by asserting that both units are indeed the same.
 //	Multiplication/Division	:	Add or subtract the powers of the units respectively.
 class base_unit {
 private:
-	str unit;
+	symbol_id id;
 	fraction power;
 
+	static fraction to_power(double p);
+
 public:
 
 	// Constructors
 
 	base_unit() noexcept;
+	base_unit(symbol_id id, const fraction &power) noexcept;
 	base_unit(const str &unit, const fraction &power);
 	base_unit(const str &unit, const int &power);
 	base_unit(const str &str_unit);
 
 	// Accessors
 
-	str& get_unit();
+	symbol_id get_id() const noexcept;
 	const str& get_unit() const;
 	fraction& get_power();
 	const fraction& get_power() const;
@@ -45,7 +86,11 @@ public:
 	// Functions
 
 	void invert();
-	template <class T> base_unit& pow(T power) {	power *= power;	return *this; }
+	base_unit& pow(const fraction &p);
+	template <class T> base_unit& pow(T p) {
+		if constexpr (std::is_integral<T>::value) return pow(fraction(int(p)));
+		else return pow(to_power(double(p)));
+	}
 	base_unit& sqrt();
 
 	// Type casts
@@ -67,7 +112,6 @@ public:
 	const base_unit operator++(int unused);
 	const base_unit operator--(int unused);
 
-	base_unit& operator  = (base_unit& rhs);
 	base_unit& operator += (const base_unit& rhs);
 	base_unit& operator -= (const base_unit& rhs);
 	base_unit& operator *= (const base_unit& rhs);
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "base_unit.h"
+#include "fraction.h"
+#include "macros.h"
+#include "typedefs.h"
+#include "unit.h"
+
+// The seven SI base dimensions, in the order of dense_unit's lanes
+enum si_dimension { dim_mass, dim_length, dim_time, dim_current, dim_temperature, dim_amount, dim_luminosity, dim_count };
+
+/*	A unit as a fixed vector of powers of the SI base dimensions (kg, m, s, A, K, mol and cd) and a scale, e.g.
+		J	= kg m^2 s^-2
+		eV	= 1.602176634e-19 kg m^2 s^-2
+
+	The powers are packed rationals: each is a 16 bit lane in Q8.8 fixed point (the power times 256), so powers from -128 to
+	127.99 in steps of 1/256, e.g. m^-3, s^1/2 or kg^-5/4. Four lanes fill a 64 bit word, so the seven fit in two words, and:
+
+		Multiplication/Division	:	add or subtract the lanes of each word at once (SWAR), and multiply or divide the scales.
+		Comparison				:	a compare of the two words (and the scales). same_dimension() ignores the scales.
+		sqrt					:	an arithmetic shift of each word, if every power is a multiple of 2/256.
+		pow						:	multiplies each lane, if the result is exact.
+
+	A power that goes out of range throws std::overflow_error, and one that cannot be represented exactly
+	(e.g. the square root of m^1/256, or a power of 1/3) throws std::domain_error.
+
+	The symbols of derived units (N, J, W, Hz, eV, ...) and the other units of the constant:: table (u, E_h, c, ...) are defined
+	in a table, keyed by symbol_id, which define() adds to (define the symbols before sharing them between threads: the table
+	is not locked). A symbol that is not in it is read as an SI prefix on one that is (MeV, GHz, fm, mg, ...), or as a quotient
+	of two (MeV/c). A unit converts to its dense form by looking up each of its base units.
+
+	Example use:
+		dense_unit energy("kg m^2 s^-2");
+		energy == dense_unit("J");					// true
+		dense_unit("N") * dense_unit("m");			// J
+		dense_unit("eV").same_dimension(energy);	// true, with a scale of 1.602176634e-19
+*/
+class dense_unit {
+public:
+	typedef std::int16_t exponent;
+	static const int fraction_bits = 8;
+	static const int one = 1 << fraction_bits;		// a power of 1
+
+private:
+	static const std::uint64_t high = 0x8000800080008000ull;		// the sign bit of each lane
+	static const std::uint64_t low  = 0x0001000100010001ull;		// the lowest bit of each lane
+
+	std::uint64_t words[2];		// lanes 0 to 3, then 4 to 7 (lane 7 is always 0)
+	double scale;
+
+	// Add or subtract the 16 bit lanes of two words, without carries between lanes, noting any lane that overflows
+	static std::uint64_t add_lanes(std::uint64_t a, std::uint64_t b, std::uint64_t& overflow) noexcept
+	{
+		std::uint64_t r = ((a & ~high) + (b & ~high)) ^ ((a ^ b) & high);
+		overflow |= (a ^ r) & (b ^ r) & high;
+		return r;
+	}
+	static std::uint64_t sub_lanes(std::uint64_t a, std::uint64_t b, std::uint64_t& overflow) noexcept
+	{
+		std::uint64_t r = ((a | high) - (b & ~high)) ^ ((a ^ ~b) & high);
+		overflow |= (a ^ b) & (a ^ r) & high;
+		return r;
+	}
+
+	void set_lane(int i, exponent e) noexcept;
+
+public:
+
+	// Construction
+
+	dense_unit() noexcept : words{ 0, 0 }, scale(1) {}
+	dense_unit(int mass, int length, int time, int current = 0, int temperature = 0, int amount = 0, int luminosity = 0, double scale = 1);
+	explicit dense_unit(const unit& u);
+	explicit dense_unit(const str& str_units);		// e.g. "kg m^2 s^-2" or "J"
+
+	static void define(const str& symbol, const dense_unit& u);
+	static dense_unit lookup(const str& symbol);		// throws std::domain_error for an undefined symbol
+	static dense_unit lookup(symbol_id id);
+
+	// Accessors
+
+	exponent get_lane(si_dimension d) const noexcept { return exponent(words[d / 4] >> (16 * (d % 4))); }		// the power times 256
+	fraction get_power(si_dimension d) const;
+	void set_power(si_dimension d, const fraction& power);
+	double get_scale() const noexcept { return scale; }
+	void set_scale(double new_scale) noexcept { scale = new_scale; }
+
+	bool dimensionless() const noexcept { return (words[0] | words[1]) == 0; }
+	bool same_dimension(const dense_unit& rhs) const noexcept { return words[0] == rhs.words[0] && words[1] == rhs.words[1]; }
+
+	// Functions
+
+	void invert();
+	dense_unit& pow(int p);
+	dense_unit& pow(const fraction& p);
+	dense_unit& sqrt();
+
+	// Type casts
+
+	str to_string() const;		// the base dimensions, after the scale if it is not 1, e.g. "0.001 kg"
+
+	// Operator overloads
+
+	bool operator == (const dense_unit& rhs) const noexcept { return same_dimension(rhs) && scale == rhs.scale; }
+	bool operator != (const dense_unit& rhs) const noexcept { return !operator==(rhs); }
+
+	dense_unit operator -() const { dense_unit u(*this); u.invert(); return u; }
+
+	dense_unit& operator += (const dense_unit& rhs) { EQ(*this, rhs); return *this; }
+	dense_unit& operator -= (const dense_unit& rhs) { EQ(*this, rhs); return *this; }
+	dense_unit& operator *= (const dense_unit& rhs)
+	{
+		std::uint64_t overflow = 0;
+		std::uint64_t w0 = add_lanes(words[0], rhs.words[0], overflow), w1 = add_lanes(words[1], rhs.words[1], overflow);
+		if (overflow) throw std::overflow_error("dense_unit: power out of range");
+		words[0] = w0; words[1] = w1; scale *= rhs.scale;
+		return *this;
+	}
+	dense_unit& operator /= (const dense_unit& rhs)
+	{
+		std::uint64_t overflow = 0;
+		std::uint64_t w0 = sub_lanes(words[0], rhs.words[0], overflow), w1 = sub_lanes(words[1], rhs.words[1], overflow);
+		if (overflow) throw std::overflow_error("dense_unit: power out of range");
+		words[0] = w0; words[1] = w1; scale /= rhs.scale;
+		return *this;
+	}
+};
+
+// Operator overloads : rhs arithmetic
+
+inline dense_unit operator + (dense_unit lhs, const dense_unit& rhs) { lhs += rhs; return lhs; }
+inline dense_unit operator - (dense_unit lhs, const dense_unit& rhs) { lhs -= rhs; return lhs; }
+inline dense_unit operator * (dense_unit lhs, const dense_unit& rhs) { lhs *= rhs; return lhs; }
+inline dense_unit operator / (dense_unit lhs, const dense_unit& rhs) { lhs /= rhs; return lhs; }
+
+std::ostream& operator << (std::ostream& os, const dense_unit& rhs);
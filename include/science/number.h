@@ -14,7 +14,7 @@
 // Flags
 
 #define STRICT_UNITS		1		// Arguments of logs, powers and trigonometric functions must be unitless.
-#define KILL_UNITS		1		// Remove all unit calculations and checks, thus speeding up the program.
+#define KILL_UNITS		1		// Remove all unit calculations and checks, thus speeding up the program. See quantity.h for checks at compile time, which cost nothing.
 #define KILL_UNCERTAINTY	0		// Remove all uncertainty calculations, thus speeding up the program.
 
 // Macros
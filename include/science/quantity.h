@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "dense_unit.h"
+#include "number.h"
+#include "typedefs.h"
+
+/*	Dimensional analysis at compile time: a quantity<Dim, T> is a T whose dimension (the powers of the SI base dimensions)
+	is part of its type, so adding a length to a time, or passing an energy where a force is expected, does not compile.
+
+		dimension<M, L, T, I, Th, N, J>	: the powers of kg, m, s, A, K, mol and cd (whole numbers), e.g. dimension<1, 2, -2> is energy.
+		dim::							: names for the common dimensions, e.g. dim::energy, dim::velocity.
+		quantity<Dim, T>				: a value of that dimension, in SI units (so a quantity of eV is stored in J).
+
+	The dimension is only a type, so a quantity is exactly a T (no storage), and its operators are those of T (no run time
+	checks): this is unit safety in release builds, where number's unit tracking is switched off (KILL_UNITS) for speed.
+	Multiplication and division give the quantity of the product or quotient dimension, and sqrt needs every power to be even.
+
+	number<T> and the constant:: table interoperate through a run time check, made once, when a value enters the typed code:
+		quantity<Dim, T>::from(n)		: n's value in SI units, converted through dense_unit. Throws std::domain_error if n's unit
+										  is not of dimension Dim (or is not a defined symbol, see dense_unit::define).
+		to_number()						: a number<T> with the SI unit of Dim.
+
+	from() can only check the unit n carries, and with KILL_UNITS (number.h, on by default) number's =, +=, -=, *= and /=
+	leave the unit as it was: h * f keeps the unit of h, and a number assigned from a constant keeps its own. So only pass
+	numbers whose unit was set when they were constructed (the constant:: table, or number(value, unc, "unit")), and do the
+	arithmetic on the quantities: quantity<dim::action>::from(h * f) passes the check without complaint.
+
+	Example use:
+		typedef quantity<dim::energy> energy;
+		auto h = quantity<dim::action>::from(constant::Planck_constant);		// checked once: J s
+		quantity<dim::frequency> f(5.0e14);
+		energy e = h * f;						// compiles: J s * s^-1 = J
+		quantity<dim::force> F = h * f;			// does not compile
+*/
+
+template <int M, int L, int Ti, int I = 0, int Th = 0, int N = 0, int J = 0>
+struct dimension
+{
+	static constexpr int mass = M, length = L, time = Ti, current = I, temperature = Th, amount = N, luminosity = J;
+
+	static constexpr bool dimensionless = M == 0 && L == 0 && Ti == 0 && I == 0 && Th == 0 && N == 0 && J == 0;
+	static dense_unit to_dense_unit() { return dense_unit(M, L, Ti, I, Th, N, J); }
+};
+
+template <class A, class B> using dimension_product = dimension<A::mass + B::mass, A::length + B::length, A::time + B::time,
+	A::current + B::current, A::temperature + B::temperature, A::amount + B::amount, A::luminosity + B::luminosity>;
+template <class A, class B> using dimension_quotient = dimension<A::mass - B::mass, A::length - B::length, A::time - B::time,
+	A::current - B::current, A::temperature - B::temperature, A::amount - B::amount, A::luminosity - B::luminosity>;
+template <class A, int P> using dimension_power = dimension<A::mass * P, A::length * P, A::time * P,
+	A::current * P, A::temperature * P, A::amount * P, A::luminosity * P>;
+template <class A> using dimension_root = dimension<A::mass / 2, A::length / 2, A::time / 2,
+	A::current / 2, A::temperature / 2, A::amount / 2, A::luminosity / 2>;
+
+template <class A> constexpr bool has_root() noexcept
+{
+	return A::mass % 2 == 0 && A::length % 2 == 0 && A::time % 2 == 0 && A::current % 2 == 0
+		&& A::temperature % 2 == 0 && A::amount % 2 == 0 && A::luminosity % 2 == 0;
+}
+
+namespace dim {
+	typedef dimension< 0,  0,  0> none;
+	typedef dimension< 1,  0,  0> mass;
+	typedef dimension< 0,  1,  0> length;
+	typedef dimension< 0,  0,  1> time;
+	typedef dimension< 0,  0,  0, 1> current;
+	typedef dimension< 0,  0,  0, 0, 1> temperature;
+	typedef dimension< 0,  0,  0, 0, 0, 1> amount;
+	typedef dimension< 0,  0,  0, 0, 0, 0, 1> luminosity;
+
+	typedef dimension< 0,  2,  0> area;
+	typedef dimension< 0,  3,  0> volume;
+	typedef dimension< 0,  0, -1> frequency;
+	typedef dimension< 0,  1, -1> velocity;
+	typedef dimension< 0,  1, -2> acceleration;
+	typedef dimension< 1,  1, -1> momentum;
+	typedef dimension< 1,  1, -2> force;
+	typedef dimension< 1, -1, -2> pressure;
+	typedef dimension< 1,  2, -2> energy;
+	typedef dimension< 1,  2, -3> power;
+	typedef dimension< 1,  2, -1> action;
+	typedef dimension< 0,  0,  1, 1> charge;
+	typedef dimension< 1,  2, -3, -1> voltage;
+	typedef dimension< 1,  2, -3, -2> resistance;
+	typedef dimension< 1,  0, -2, -1> magnetic_field;
+	typedef dimension< 1,  2, -2, 0, -1> entropy;
+}
+
+template <class Dim, class T = double>
+class quantity {
+	T val;
+
+public:
+	typedef Dim dimension_type;
+	typedef T value_type;
+
+	// Construction
+
+	constexpr quantity() : val() {}
+	constexpr explicit quantity(const T& val) : val(val) {}
+	template <class U> constexpr explicit quantity(const quantity<Dim, U>& q) : val(T(q.get())) {}
+
+	// n must have its unit from construction, not from arithmetic or assignment (see above, KILL_UNITS)
+	static quantity from(const number<T>& n)
+	{
+		dense_unit u(n.get_unit());
+		if (!u.same_dimension(Dim::to_dense_unit())) throw std::domain_error("quantity: " + u.to_string() + " is not of dimension " + Dim::to_dense_unit().to_string());
+		return quantity(T(n.get_number() * u.get_scale()));
+	}
+
+	// Accessors
+
+	constexpr const T& get() const noexcept { return val; }
+	constexpr void set(const T& new_val) noexcept { val = new_val; }
+
+	// Type casts
+
+	number<T> to_number(double uncertainty = 0) const { return number<T>(val, uncertainty, Dim::to_dense_unit().to_string()); }
+	str to_string() const { std::ostringstream os; os << val; str u = Dim::to_dense_unit().to_string(); return u.empty() ? os.str() : os.str() + " " + u; }
+
+	template <class D = Dim, class = typename std::enable_if<D::dimensionless>::type> constexpr operator T() const noexcept { return val; }		// only a pure number
+
+	// Operator overloads
+
+	constexpr bool operator == (const quantity& rhs) const { return val == rhs.val; }
+	constexpr bool operator != (const quantity& rhs) const { return val != rhs.val; }
+	constexpr bool operator <  (const quantity& rhs) const { return val <  rhs.val; }
+	constexpr bool operator >  (const quantity& rhs) const { return val >  rhs.val; }
+	constexpr bool operator <= (const quantity& rhs) const { return val <= rhs.val; }
+	constexpr bool operator >= (const quantity& rhs) const { return val >= rhs.val; }
+
+	constexpr quantity operator -() const { return quantity(-val); }
+
+	constexpr quantity& operator += (const quantity& rhs) { val += rhs.val; return *this; }
+	constexpr quantity& operator -= (const quantity& rhs) { val -= rhs.val; return *this; }
+	constexpr quantity& operator *= (const T& rhs) { val *= rhs; return *this; }
+	constexpr quantity& operator /= (const T& rhs) { val /= rhs; return *this; }
+};
+
+static_assert(sizeof(quantity<dim::energy, double>) == sizeof(double), "a quantity is only its value");
+
+// Operator overloads : rhs arithmetic
+
+template <class D, class T> constexpr quantity<D, T> operator + (quantity<D, T> lhs, const quantity<D, T>& rhs) { lhs += rhs; return lhs; }
+template <class D, class T> constexpr quantity<D, T> operator - (quantity<D, T> lhs, const quantity<D, T>& rhs) { lhs -= rhs; return lhs; }
+
+template <class D, class T> constexpr quantity<D, T> operator * (quantity<D, T> lhs, const T& rhs) { lhs *= rhs; return lhs; }
+template <class D, class T> constexpr quantity<D, T> operator / (quantity<D, T> lhs, const T& rhs) { lhs /= rhs; return lhs; }
+template <class D, class T> constexpr quantity<D, T> operator * (const T& lhs, quantity<D, T> rhs) { rhs *= lhs; return rhs; }
+template <class D, class T> constexpr quantity<dimension_quotient<dim::none, D>, T> operator / (const T& lhs, const quantity<D, T>& rhs) { return quantity<dimension_quotient<dim::none, D>, T>(lhs / rhs.get()); }
+
+template <class A, class B, class T> constexpr quantity<dimension_product<A, B>, T> operator * (const quantity<A, T>& lhs, const quantity<B, T>& rhs) { return quantity<dimension_product<A, B>, T>(lhs.get() * rhs.get()); }
+template <class A, class B, class T> constexpr quantity<dimension_quotient<A, B>, T> operator / (const quantity<A, T>& lhs, const quantity<B, T>& rhs) { return quantity<dimension_quotient<A, B>, T>(lhs.get() / rhs.get()); }
+
+template <int P, class D, class T> quantity<dimension_power<D, P>, T> pow(const quantity<D, T>& q) { return quantity<dimension_power<D, P>, T>(T(std::pow(q.get(), P))); }
+template <class D, class T> quantity<dimension_root<D>, T> sqrt(const quantity<D, T>& q)
+{
+	static_assert(has_root<D>(), "sqrt of a quantity needs every power of its dimension to be even");
+	return quantity<dimension_root<D>, T>(T(std::sqrt(q.get())));
+}
+
+template <class D, class T> std::ostream& operator << (std::ostream& os, const quantity<D, T>& q) { os << q.to_string(); return os; }
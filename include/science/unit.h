@@ -7,7 +7,14 @@
 //		- overload subscript operator, to access single unit.
 //		- add base_unit overloads
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
 #include <string>
+#include <unordered_map>
 #include "fraction.h"
 #include "base_unit.h"
 #include <vector>
@@ -18,12 +25,15 @@
 typedef std::vector<base_unit> container;
 
 /* 	A unit, e.g. kg m^2 s^-3
-	Technically, it's an iterable of base_unit objects.
+	Technically, it's an iterable of base_unit objects, kept in a canonical form: sorted by symbol (see symbol_registry::before),
+	with one base unit per symbol and no zero powers, so "kg m" == "m kg" and "m s s^-1" == "m".
+	Its hash (std::hash<unit>) is computed whenever it changes, so units can be keys of hash maps at no extra cost,
+	and comparisons of units that differ usually stop at the hashes.
 
 	Uses:
 		Addition/Subtraction	:	asserts that the units are the same.
-		Multiplication/Division	:	new base units are appended, and existing base_units
-									have their powers added or subtract respectively.
+		Multiplication/Division	:	a merge of the two sorted lists of base units, adding or subtracting the powers
+									of those in both, in time linear in their lengths.
 		N.B. if DEBUG flag is False, then asserts are removed.
 
 	Examples:
@@ -36,12 +46,18 @@ class unit
 {
 private:
 	container units;
+	std::size_t hash_code;
 	
 	void swap(unit& rhs) {
 		using std::swap;
 		swap(units, rhs.units);
+		swap(hash_code, rhs.hash_code);
 	}
 
+	void normalize();			// sort, merge and drop zero powers, then rehash
+	void rehash() noexcept;
+	void merge(const unit& rhs, bool divide);
+
 public:
 
 	// Construction 
@@ -50,12 +66,14 @@ public:
 	unit(const container &units);
 	unit(const std::initializer_list<base_unit> &units);
 	unit(str str_units);
-	template <size_t SIZE> unit(std::array<base_unit, SIZE> &units) : units(units) {}
+	template <size_t SIZE> unit(const std::array<base_unit, SIZE> &units) : units(units.begin(), units.end()), hash_code(0) { normalize(); }
 	unit(const unit& u);
 	unit(unit&& u);
 
 	// Accessors
 
+	const container& get_units() const noexcept { return units; }		// in canonical order
+	std::size_t hash() const noexcept { return hash_code; }
 	void set(str str_units);
 
 	// Type casts
@@ -64,7 +82,9 @@ public:
 
 	// Functions
 
-	auto contains_type(const str &unit_name);
+	static void canonicalize(container &units);				// sorts and merges in place, as for a unit
+	container::const_iterator find(symbol_id id) const;		// the base unit of that symbol, or get_units().end()
+	container::const_iterator contains_type(const str &unit_name) const;
 	void mul_units(const unit &unit);
 	void invert();
 	template <class T> unit& pow(T power) {
@@ -74,6 +94,7 @@ public:
 		{
 			*first = (*first).pow(power);
 		}
+		normalize();		// a power of 0 drops every base unit
 		return *this;
 	}
 	unit& sqrt();
@@ -96,6 +117,34 @@ public:
 	unit& operator /= (const unit& rhs);
 };
 
+/*	The parsed base units of every unit string seen so far, so that constructing a unit from the same string again
+	(e.g. the hundreds of numbers in constants.h, in every translation unit) is one hash lookup and a copy, rather than a parse.
+	The parsed units are shared and immutable. Thread safe: a string that is already cached only takes a shared lock.
+	Strings are kept until clear(); hits() and misses() count the lookups that found a string and those that had to parse it.
+*/
+class unit_cache
+{
+	std::unordered_map<str, std::shared_ptr<const container> > parsed;
+	mutable std::shared_mutex mutex;
+	std::atomic<std::uint64_t> hit_count, miss_count;
+
+	unit_cache() : hit_count(0), miss_count(0) {}
+
+public:
+	unit_cache(const unit_cache&) = delete;
+	unit_cache& operator = (const unit_cache&) = delete;
+
+	static unit_cache& instance();
+	static container parse(const str& str_units);		// without the cache, e.g. "kg m^2 s^-3"
+
+	std::shared_ptr<const container> get(const str& str_units);		// parsing it if it is new
+
+	std::uint64_t hits() const noexcept { return hit_count.load(std::memory_order_relaxed); }
+	std::uint64_t misses() const noexcept { return miss_count.load(std::memory_order_relaxed); }
+	std::size_t size() const;
+	void clear();
+};
+
 unit operator + (unit lhs, const unit& rhs);
 unit operator - (unit lhs, const unit& rhs);
 unit operator * (unit lhs, const unit& rhs);
@@ -104,3 +153,8 @@ unit operator / (unit lhs, const unit& rhs);
 std::ostream& operator << (std::ostream& os, const unit& rhs);
 std::istream& operator >> (std::istream& in, unit& rhs);
 
+namespace std {
+	template <> struct hash<unit> {
+		std::size_t operator () (const unit& u) const noexcept { return u.hash(); }
+	};
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "bound.h"
+
+/*	Bounds whose limits are shared (the flyweight pattern), for large tables of values that use only a handful of ranges.
+
+		range_registry<T, Id, Tag>	: the distinct ranges, each interned once and numbered by an Id.
+		shared_bound<T, Policy, Id, Tag>	: a bound that stores its value and the Id of its range,
+									  e.g. 16 bytes for a double (10 used) rather than the 24 of a bound<double>.
+		shared_cyclic<T, Id, Tag>	: the same, cycling between its limits (see cyclic.h).
+
+	The ranges are stored contiguously, in order of Id, so finding the limits of a value is a single indexed load, and
+	a few ranges stay in the cache for the whole table. Interning looks up a hash table, so identical ranges share one Id.
+
+	There is one registry per T, Id and Tag: a Tag (any type) gives a table a registry of its own, e.g. so that its Ids stay small.
+	Ranges are never removed, and interning is not thread safe: intern the ranges before sharing the values between threads
+	(reading them is then safe).
+
+	Example use:
+		shared_bound<double> gain(0.5, 0.0, 1.0), pan(0.0, -1.0, 1.0), mix(0.3, 0.0, 1.0);		// gain and mix share a range
+		gain += 0.7;		// 1.0
+		std::vector<shared_bound<float> > parameters(1000000, shared_bound<float>(0.0f, 0.0f, 1.0f));		// 8 MB, not 12
+*/
+template <class T, class Id = std::uint16_t, class Tag = void>
+class range_registry {
+	static_assert(std::is_unsigned<Id>::value, "range_registry requires an unsigned Id");
+
+public:
+	struct range {
+		T min, max;
+		bool operator == (const range& rhs) const { return min == rhs.min && max == rhs.max; }
+	};
+
+private:
+	struct hasher {
+		std::size_t operator () (const range& r) const { std::size_t h = std::hash<T>()(r.min); return h ^ (std::hash<T>()(r.max) + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2)); }
+	};
+
+	std::vector<range> ranges;							// by Id
+	std::unordered_map<range, Id, hasher> ids;			// by range, for interning
+
+	range_registry() {}
+
+public:
+	range_registry(const range_registry&) = delete;
+	range_registry& operator = (const range_registry&) = delete;
+
+	static range_registry& instance() { static range_registry registry; return registry; }
+
+	// The Id of the range [min, max], adding it if it is new. Throws std::length_error if there are more ranges than Ids.
+	Id intern(const T& min, const T& max)
+	{
+		range r = { min, max };
+		auto found = ids.find(r);
+		if (found != ids.end()) return found->second;
+		if (ranges.size() > std::size_t(std::numeric_limits<Id>::max())) throw std::length_error("range_registry: too many ranges for the Id type");
+		Id id = Id(ranges.size());
+		ranges.push_back(r);
+		ids.emplace(r, id);
+		return id;
+	}
+
+	const range& operator [] (Id id) const { return ranges[id]; }
+	Id at(Id id) const { if (id >= ranges.size()) throw std::out_of_range("range_registry: unknown range id"); return id; }		// id, if it has been interned
+	std::size_t size() const noexcept { return ranges.size(); }
+};
+
+template <class T, class Policy = bound_clamp, class Id = std::uint16_t, class Tag = void>
+class shared_bound {
+public:
+	typedef T value_type;
+	typedef Policy policy;
+	typedef range_registry<T, Id, Tag> registry_type;
+
+protected:
+	T val;
+	Id id;
+
+	const typename registry_type::range& limits() const { return registry_type::instance()[id]; }
+
+	// bound_wrap steps an integer round the range (see wrap_add), so the result is already in range: no check after += or -=.
+	static const bool in_range_steps = std::is_same<Policy, bound_wrap>::value && is_integer<T>::value;
+
+public:
+	static registry_type& registry() { return registry_type::instance(); }
+
+	shared_bound() : val(), id(registry().intern(T(), T())) {}
+	shared_bound(const T &val, const T &min, const T &max) : val(val), id(registry().intern(min, max)) { check(); }
+	shared_bound(const T &val, Id range_id) : val(val), id(registry().at(range_id)) { check(); }		// throws std::out_of_range for an Id never interned
+	explicit shared_bound(const bound<T, Policy>& b) : shared_bound(b.get(), b.get_min(), b.get_max()) {}
+
+	void check() { const typename registry_type::range& r = limits(); Policy::check(val, r.min, r.max); }
+
+	std::ostream& print(std::ostream& os) const { os << get_min() << " <= " << val << " <= " << get_max(); return os; }
+
+	T range() const { return get_max() - get_min(); }
+	T ratio() const { return (val - get_min()) / range(); }
+
+	// Accessors
+
+	T& get() noexcept { return val; }
+	const T& get() const noexcept { return val; }
+	const T& get_min() const { return limits().min; }
+	const T& get_max() const { return limits().max; }
+	Id range_id() const noexcept { return id; }
+
+	void set(const T &new_val) { val = new_val; check(); }
+	void set_range(const T &new_min, const T &new_max) { id = registry().intern(new_min, new_max); check(); }
+	void set_range(Id range_id) { id = registry().at(range_id); check(); }
+
+	// Type casts
+
+	bound<T, Policy> to_bound() const { return bound<T, Policy>(val, get_min(), get_max()); }
+	std::string to_string() const { return std::to_string(val); }
+
+	operator T() const { return val; }
+
+	// Operator overloads
+
+	shared_bound& operator  = (const T &rhs) { val = rhs; check(); return *this; }
+	shared_bound& operator += (const T &rhs) { const typename registry_type::range& r = limits(); Policy::add(val, rhs, r.min, r.max); if constexpr (!in_range_steps) check(); return *this; }
+	shared_bound& operator -= (const T &rhs) { const typename registry_type::range& r = limits(); Policy::sub(val, rhs, r.min, r.max); if constexpr (!in_range_steps) check(); return *this; }
+	shared_bound& operator *= (const T &rhs) { Policy::mul(val, rhs); check(); return *this; }
+	shared_bound& operator /= (const T &rhs) { Policy::div(val, rhs); check(); return *this; }
+
+	shared_bound& operator += (const shared_bound& rhs) { return *this += rhs.val; }
+	shared_bound& operator -= (const shared_bound& rhs) { return *this -= rhs.val; }
+	shared_bound& operator *= (const shared_bound& rhs) { return *this *= rhs.val; }
+	shared_bound& operator /= (const shared_bound& rhs) { return *this /= rhs.val; }
+
+	bool   operator == (const T &rhs) const { return     (val == rhs); }
+	bool   operator != (const T &rhs) const { return !operator==(rhs); }
+	bool   operator <  (const T &rhs) const { return       val < rhs ; }
+	bool   operator >  (const T &rhs) const { return       val > rhs ; }
+	bool   operator <= (const T &rhs) const { return !operator >(rhs); }
+	bool   operator >= (const T &rhs) const { return !operator <(rhs); }
+
+	bool   operator == (const shared_bound& rhs) const { return val == rhs.val && id == rhs.id; }		// equal ranges have equal Ids
+	bool   operator != (const shared_bound& rhs) const { return !operator==(rhs); }
+	bool   operator <  (const shared_bound& rhs) const { return val < rhs.val; }
+	bool   operator >  (const shared_bound& rhs) const { return val > rhs.val; }
+	bool   operator <= (const shared_bound& rhs) const { return !operator>(rhs); }
+	bool   operator >= (const shared_bound& rhs) const { return !operator<(rhs); }
+
+	shared_bound& operator++() { return *this += T(1); }
+	shared_bound& operator--() { return *this -= T(1); }
+	const shared_bound operator++(int unused) { shared_bound result(*this); ++(*this); return result; }
+	const shared_bound operator--(int unused) { shared_bound result(*this); --(*this); return result; }
+};
+
+template <class T, class Id = std::uint16_t, class Tag = void>
+using shared_cyclic = shared_bound<T, bound_wrap, Id, Tag>;
+
+template <class T, class P, class I, class G> shared_bound<T, P, I, G> operator+ (shared_bound<T, P, I, G> lhs, const T& rhs) { lhs += rhs; return lhs; }
+template <class T, class P, class I, class G> shared_bound<T, P, I, G> operator- (shared_bound<T, P, I, G> lhs, const T& rhs) { lhs -= rhs; return lhs; }
+template <class T, class P, class I, class G> shared_bound<T, P, I, G> operator* (shared_bound<T, P, I, G> lhs, const T& rhs) { lhs *= rhs; return lhs; }
+template <class T, class P, class I, class G> shared_bound<T, P, I, G> operator/ (shared_bound<T, P, I, G> lhs, const T& rhs) { lhs /= rhs; return lhs; }
+
+template <class T, class P, class I, class G> shared_bound<T, P, I, G> operator+ (shared_bound<T, P, I, G> lhs, const shared_bound<T, P, I, G>& rhs) { lhs += rhs; return lhs; }
+template <class T, class P, class I, class G> shared_bound<T, P, I, G> operator- (shared_bound<T, P, I, G> lhs, const shared_bound<T, P, I, G>& rhs) { lhs -= rhs; return lhs; }
+template <class T, class P, class I, class G> shared_bound<T, P, I, G> operator* (shared_bound<T, P, I, G> lhs, const shared_bound<T, P, I, G>& rhs) { lhs *= rhs; return lhs; }
+template <class T, class P, class I, class G> shared_bound<T, P, I, G> operator/ (shared_bound<T, P, I, G> lhs, const shared_bound<T, P, I, G>& rhs) { lhs /= rhs; return lhs; }
+
+template <class T, class P, class I, class G> std::ostream& operator << (std::ostream& os, const shared_bound<T, P, I, G>& a) { a.print(os); return os; }
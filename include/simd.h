@@ -0,0 +1,115 @@
+#pragma once
+
+/*	Support for the SIMD (vectorised) batch kernels, e.g. those of fraction_array.
+
+		simd_isa			: the instruction sets the kernels are written for.
+		active_isa()		: the best instruction set supported by this CPU (and OS), detected once at run time.
+		aligned_allocator	: a std::allocator that aligns every block to a cache line (64 bytes),
+							  so that the kernels can use aligned loads and no element straddles two lines.
+
+	The kernels themselves are compiled for their instruction set with TARGET_AVX2 / TARGET_AVX512,
+	so the rest of the program does not need to be built with -mavx2, and still runs on older CPUs.
+*/
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#define SIMD_DISPATCH	1		// Pick the kernels at run time, from the instruction sets this CPU supports.
+								// Set to 0 to always use the scalar kernels (e.g. to compare results or timings).
+
+// Instruction sets
+//------------------------------------------------------------------------------------
+
+enum simd_isa { isa_scalar = 0, isa_avx2 = 1, isa_avx512 = 2 };		// avx512 means AVX-512 F
+
+#if defined(__GNUC__) || defined(__clang__)
+	#define TARGET_AVX2		__attribute__((target("avx2")))
+	#define TARGET_AVX512	__attribute__((target("avx2,avx512f")))
+#else
+	#define TARGET_AVX2
+	#define TARGET_AVX512
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	#define HAS_X86_SIMD 1
+#else
+	#define HAS_X86_SIMD 0
+#endif
+
+#if HAS_X86_SIMD && defined(_MSC_VER) && !defined(__clang__)
+	#include <intrin.h>
+#endif
+
+// Return the best instruction set supported by this CPU, and enabled by its operating system.
+inline simd_isa detect_isa() noexcept
+{
+#if !SIMD_DISPATCH || !HAS_X86_SIMD
+	return isa_scalar;
+#elif defined(__GNUC__) || defined(__clang__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) return isa_avx512;
+	if (__builtin_cpu_supports("avx2"))    return isa_avx2;
+	return isa_scalar;
+#else
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) return isa_scalar;
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx) return isa_scalar;
+	unsigned long long xcr0 = _xgetbv(0);
+	if ((xcr0 & 0x6) != 0x6) return isa_scalar;					// the OS saves the ymm registers
+	__cpuidex(info, 7, 0);
+	if ((info[1] & (1 << 16)) && (xcr0 & 0xE6) == 0xE6) return isa_avx512;		// and the zmm / mask registers
+	if (info[1] & (1 << 5)) return isa_avx2;
+	return isa_scalar;
+#endif
+}
+
+inline simd_isa active_isa() noexcept
+{
+	static const simd_isa isa = detect_isa();
+	return isa;
+}
+
+// Aligned allocation
+//------------------------------------------------------------------------------------
+
+const std::size_t simd_alignment = 64;		// a cache line, and the width of an AVX-512 register
+
+inline void* aligned_malloc(std::size_t bytes)
+{
+	void* p;
+#if defined(_MSC_VER)
+	p = _aligned_malloc(bytes ? bytes : 1, simd_alignment);
+#else
+	if (posix_memalign(&p, simd_alignment, bytes ? bytes : 1) != 0) p = nullptr;
+#endif
+	if (!p) throw std::bad_alloc();
+	return p;
+}
+
+inline void aligned_free(void* p) noexcept
+{
+#if defined(_MSC_VER)
+	_aligned_free(p);
+#else
+	std::free(p);
+#endif
+}
+
+template <class T> struct aligned_allocator
+{
+	typedef T value_type;
+
+	aligned_allocator() noexcept {}
+	template <class U> aligned_allocator(const aligned_allocator<U>&) noexcept {}
+
+	T* allocate(std::size_t n) { return static_cast<T*>(aligned_malloc(n * sizeof(T))); }
+	void deallocate(T* p, std::size_t) noexcept { aligned_free(p); }
+
+	template <class U> struct rebind { typedef aligned_allocator<U> other; };
+	template <class U> bool operator == (const aligned_allocator<U>&) const noexcept { return true; }
+	template <class U> bool operator != (const aligned_allocator<U>&) const noexcept { return false; }
+};
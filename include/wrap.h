@@ -0,0 +1,175 @@
+#pragma once
+
+/*	Wrapping values into a cyclic range, as used by cyclic and cyclic_array.
+
+		wrap(val, min, max)		: wrap one value, for limits that change from call to call.
+		wrap_add(val, rhs, ...)	: val + rhs (or val - rhs) wrapped, for integers already in range, without overflowing on the way.
+		wrap_engine<T>			: wrap many values into the same range, with the divisor worked out once.
+		invariant_divisor<U>	: the remainder by a divisor fixed at run time, with multiplications instead of a division.
+
+	Integers cycle through the inclusive range [min, max], whose size is max - min + 1 (so max + 1 wraps to min).
+	The offsets from min are taken in unsigned arithmetic, so they cannot overflow, even for ranges wider than half of T.
+
+	Floating point values cycle through the half-open range [min, max), whose period is max - min (so max wraps to min,
+	as for angles in [0, 2 pi)). A value less than one period outside is wrapped with a single addition or subtraction,
+	and only values further out fall back to std::fmod.
+*/
+
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include "int_traits.h"
+
+// Invariant divisor
+//------------------------------------------------------------------------------------
+//		a % d for a divisor fixed at run time, by direct computation of the remainder with two multiplications
+//		(Lemire, Kaser and Kurz, "Faster remainder by direct computation", 2019): with M = ceil(2^2N / d),
+//		a % d = ((M a) mod 2^2N) d / 2^2N, exactly, for all N bit a and d. Falls back to % for 64 bit
+//		integers where there is no 128 bit type.
+
+template <class U>
+class invariant_divisor
+{
+	static_assert(std::is_unsigned<U>::value, "invariant_divisor requires an unsigned integer type");
+
+#if HAS_INT128
+	static const bool direct = sizeof(U) <= sizeof(std::uint64_t);
+	typedef typename std::conditional<(sizeof(U) <= sizeof(std::uint32_t)), std::uint64_t, uint128_t>::type M;
+#else
+	static const bool direct = sizeof(U) <= sizeof(std::uint32_t);
+	typedef std::uint64_t M;
+#endif
+
+	U d;
+	M m;
+
+public:
+	invariant_divisor() noexcept : d(1), m(0) {}
+	explicit invariant_divisor(U divisor) noexcept : d(divisor), m(direct ? M(~M(0) / divisor + 1) : 0) {}		// divisor != 0
+
+	U divisor() const noexcept { return d; }
+
+	U remainder(U a) const noexcept
+	{
+		if constexpr (!direct) return a % d;
+		else if constexpr (sizeof(M) == sizeof(std::uint64_t)) {
+			std::uint64_t low = m * a, high = 0, unused = 0;
+			mul_full(low, std::uint64_t(d), high, unused);
+			return U(high);
+		}
+#if HAS_INT128
+		else {
+			// (low * d) >> 128 for a 128 bit low, from its two 64 bit halves
+			uint128_t low = m * a;
+			uint128_t t1 = uint128_t(std::uint64_t(low)) * d, t2 = uint128_t(std::uint64_t(low >> 64)) * d;
+			return U((t2 + (t1 >> 64)) >> 64);
+		}
+#endif
+	}
+};
+
+// Wrap engines
+//------------------------------------------------------------------------------------
+
+template <class T>
+class integer_wrap
+{
+	typedef typename unsigned_of<T>::type U;
+
+	T min;
+	U size;							// max - min + 1, or 0 if the range is all of T
+	invariant_divisor<U> range;
+
+public:
+	integer_wrap(T min, T max) noexcept : min(min), size(U(U(max) - U(min) + 1)), range(size ? size : 1) {}
+
+	T operator () (T val) const noexcept
+	{
+		if (size == 0) return val;
+		if (val < min) {
+			U below = range.remainder(U(U(min) - U(val)));
+			return below == 0 ? min : T(U(U(min) + size - below));
+		}
+		U offset = U(U(val) - U(min));
+		return offset < size ? val : T(U(U(min) + range.remainder(offset)));
+	}
+};
+
+template <class T>
+class floating_wrap
+{
+	T min, max, period;
+
+public:
+	floating_wrap(T min, T max) noexcept : min(min), max(max), period(max - min) {}
+
+	T operator () (T val) const noexcept
+	{
+		if (val >= max) {
+			val -= period;
+			if (val >= max) val = min + std::fmod(val - min, period);
+		}
+		else if (val < min) {
+			val += period;
+			if (val < min) val = min + std::fmod(val - min, period) + period;		// fmod keeps the sign of val - min, i.e. negative
+			if (val >= max) val = min;		// a value just below min can round up to max
+		}
+		return val;
+	}
+};
+
+template <class T> using wrap_engine = typename std::conditional<std::is_floating_point<T>::value, floating_wrap<T>, integer_wrap<T> >::type;
+
+// Wrap one value into [min, max] (integers) or [min, max) (floating point).
+// Values within one range of the limits are wrapped with a single addition or subtraction: further out they need a division.
+template <class T> T wrap(T val, const T& min, const T& max) noexcept
+{
+	if constexpr (std::is_floating_point<T>::value) return floating_wrap<T>(min, max)(val);
+	else {
+		typedef typename unsigned_of<T>::type U;
+		U size = U(U(max) - U(min) + 1);
+		if (size == 0) return val;
+		if (val < min) {
+			U below = U(U(min) - U(val));
+			if (below > size) below %= size;
+			return below == 0 ? min : T(U(U(min) + size - below));
+		}
+		U offset = U(U(val) - U(min));
+		if (offset >= size) offset = offset - size < size ? offset - size : offset % size;
+		return T(U(U(min) + offset));
+	}
+}
+
+// val + rhs, or val - rhs if negate, wrapped into [min, max], for integers. Adding and then wrapping is wrong whenever the
+// addition itself overflows (e.g. for unsigned, 0 - 1 is the largest value rather than min - 1, and for signed it is undefined),
+// so instead the offset of val from min is stepped forwards in unsigned arithmetic, which cannot overflow (as atomic_cyclic).
+// It takes no division unless |rhs| is a whole range or more. val must already be in [min, max], as the value of a cyclic is.
+//
+//		wrap_step(rhs, size, negate)		: rhs (or -rhs) as a step forwards, in [0, size]. Work it out once to add the same rhs to many values.
+//		wrap_advance(val, step, min, size)	: val stepped forwards round the range, with a single compare and subtract.
+//
+// A size of 0 is the whole of T, where the steps are simply modulo 2^N.
+
+template <class T> typename unsigned_of<T>::type wrap_step(T rhs, typename unsigned_of<T>::type size, bool negate = false) noexcept
+{
+	typedef typename unsigned_of<T>::type U;
+	U r = U(rhs);
+	bool back = negate;
+	if constexpr (T(-1) < T(0)) if (rhs < T(0)) { r = U(U(0) - r); back = !back; }
+	if (r >= size && size != 0) r = U(r % size);		// only for a step of a whole range or more
+	return back ? U(size - r) : r;					// a step back is a step forwards by the rest of the range
+}
+
+template <class T> T wrap_advance(T val, typename unsigned_of<T>::type step, const T& min, typename unsigned_of<T>::type size) noexcept
+{
+	typedef typename unsigned_of<T>::type U;
+	U offset = U(U(val) - U(min)), rest = U(size - step);		// the offset at which the step passes max
+	return T(U(U(min) + (offset >= rest ? U(offset - rest) : U(offset + step))));
+}
+
+template <class T> T wrap_add(T val, T rhs, const T& min, const T& max, bool negate = false) noexcept
+{
+	typedef typename unsigned_of<T>::type U;
+	U size = U(U(max) - U(min) + 1);
+	return wrap_advance(val, wrap_step(rhs, size, negate), min, size);
+}
@@ -0,0 +1,85 @@
+#include "stdafx.h"
+#include <cmath>
+#include "big_fraction.h"
+
+// Private
+
+void big_fraction::normalise()
+{
+	if (den.sign() == 0) throw std::domain_error("big_fraction: zero denominator");
+	big_int divisor = gcd(num, den);
+	if (divisor != big_int(1)) { num /= divisor; den /= divisor; }
+	if (den.sign() < 0) { num.negate(); den.negate(); }
+}
+
+// Knuth's addition: with g = gcd(b, d), a/b + c/d = (a d/g + c b/g) / (b/g d) and only g (not the product) needs reducing.
+void big_fraction::add_slow(const big_fraction& rhs, bool subtract)
+{
+	big_int c = subtract ? -rhs.num : rhs.num;
+	big_int g = gcd(den, rhs.den);
+	if (g == big_int(1))
+	{
+		num = num * rhs.den + c * den;
+		den *= rhs.den;
+	}
+	else
+	{
+		big_int t = num * (rhs.den / g) + c * (den / g);
+		big_int h = gcd(t, g);
+		num = t / h;
+		den = (den / g) * (rhs.den / h);
+	}
+	if (num.sign() == 0) den = 1;
+}
+
+// Cross-cancel before multiplying, so the product is already in lowest terms.
+void big_fraction::multiply_slow(const big_int& rhs_num, const big_int& rhs_den)
+{
+	if (num.sign() == 0 || rhs_num.sign() == 0) { num = 0; den = 1; return; }
+	big_int g = gcd(num, rhs_den), h = gcd(rhs_num, den);
+	num = (num / g) * (rhs_num / h);
+	den = (den / h) * (rhs_den / g);
+}
+
+// Type casts
+
+double big_fraction::to_double() const
+{
+	if (is_small()) return double(num.get_small()) / double(den.get_small());
+
+	// Divide with 64 significant bits in the quotient, then scale back by the binary exponent.
+	long shift = 64 - (long(num.bits()) - long(den.bits()));
+	big_int quotient = shift >= 0 ? (num << std::size_t(shift)) / den : num / (den << std::size_t(-shift));
+	return std::ldexp(quotient.to_double(), int(-shift));
+}
+
+str big_fraction::to_string() const
+{
+	if (den == big_int(1)) return num.to_string();
+	return num.to_string() + "/" + den.to_string();
+}
+
+// Functions
+
+big_fraction& big_fraction::invert()
+{
+	if (num.sign() == 0) throw std::domain_error("big_fraction: division by zero");
+	std::swap(num, den);
+	if (den.sign() < 0) { num.negate(); den.negate(); }
+	return *this;
+}
+
+// Operator overloads : streams
+
+std::ostream& operator << (std::ostream& os, const big_fraction& rhs) {
+	os << rhs.to_string();
+	return os;
+}
+std::istream& operator >> (std::istream& in, big_fraction& rhs) {
+	str s;
+	in >> s;
+	std::size_t position = s.find('/');
+	if (position == str::npos) rhs = big_fraction(big_int(s));
+	else rhs = big_fraction(big_int(s.substr(0, position)), big_int(s.substr(position + 1)));
+	return in;
+}
@@ -0,0 +1,485 @@
+#include "stdafx.h"
+#include <stdexcept>
+#include <utility>
+#include "big_int.h"
+#include "gcd.h"
+
+typedef big_int::limb limb;
+typedef big_int::magnitude magnitude;
+
+// Magnitudes
+//		Unsigned arithmetic on vectors of 32 bit limbs (least significant first, no leading zeros).
+//		Intermediates are 64 bit, so every function is portable.
+//------------------------------------------------------------------------------------
+
+static void trim(magnitude& a) { while (!a.empty() && a.back() == 0) a.pop_back(); }
+
+static int leading_zeros(limb x)
+{
+	int n = 0;
+	if (x == 0) return 32;
+	while ((x & 0x80000000u) == 0) { x <<= 1; ++n; }
+	return n;
+}
+
+static std::size_t bit_length(const magnitude& a)
+{
+	return a.empty() ? 0 : a.size() * 32 - leading_zeros(a.back());
+}
+
+static int compare(const magnitude& a, const magnitude& b)
+{
+	if (a.size() != b.size()) return a.size() < b.size() ? -1 : 1;
+	for (std::size_t i = a.size(); i-- > 0;)
+	{
+		if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+	}
+	return 0;
+}
+
+static magnitude add(const magnitude& a, const magnitude& b)
+{
+	const magnitude& x = a.size() >= b.size() ? a : b;
+	const magnitude& y = a.size() >= b.size() ? b : a;
+	magnitude result(x.size() + 1);
+	std::uint64_t carry = 0;
+	for (std::size_t i = 0; i < x.size(); ++i)
+	{
+		carry += std::uint64_t(x[i]) + (i < y.size() ? y[i] : 0);
+		result[i] = limb(carry);
+		carry >>= 32;
+	}
+	result[x.size()] = limb(carry);
+	trim(result);
+	return result;
+}
+
+// Return a - b, where a >= b.
+static magnitude subtract(const magnitude& a, const magnitude& b)
+{
+	magnitude result(a.size());
+	std::int64_t borrow = 0;
+	for (std::size_t i = 0; i < a.size(); ++i)
+	{
+		std::int64_t t = std::int64_t(a[i]) - (i < b.size() ? b[i] : 0) - borrow;
+		borrow = t < 0;
+		result[i] = limb(t);
+	}
+	trim(result);
+	return result;
+}
+
+static magnitude multiply(const magnitude& a, const magnitude& b)
+{
+	if (a.empty() || b.empty()) return magnitude();
+	magnitude result(a.size() + b.size());
+	for (std::size_t i = 0; i < a.size(); ++i)
+	{
+		std::uint64_t carry = 0;
+		for (std::size_t j = 0; j < b.size(); ++j)
+		{
+			carry += std::uint64_t(a[i]) * b[j] + result[i + j];
+			result[i + j] = limb(carry);
+			carry >>= 32;
+		}
+		result[i + b.size()] = limb(carry);
+	}
+	trim(result);
+	return result;
+}
+
+// a = a * m + add
+static void multiply_add(magnitude& a, limb m, limb add)
+{
+	std::uint64_t carry = add;
+	for (std::size_t i = 0; i < a.size(); ++i)
+	{
+		carry += std::uint64_t(a[i]) * m;
+		a[i] = limb(carry);
+		carry >>= 32;
+	}
+	if (carry) a.push_back(limb(carry));
+}
+
+static magnitude shift_left(const magnitude& a, std::size_t shift)
+{
+	if (a.empty()) return a;
+	std::size_t limbs = shift / 32, bits = shift % 32;
+	magnitude result(a.size() + limbs + 1, 0);
+	for (std::size_t i = 0; i < a.size(); ++i)
+	{
+		std::uint64_t x = std::uint64_t(a[i]) << bits;
+		result[i + limbs] |= limb(x);
+		result[i + limbs + 1] |= limb(x >> 32);
+	}
+	trim(result);
+	return result;
+}
+
+static magnitude shift_right(const magnitude& a, std::size_t shift)
+{
+	std::size_t limbs = shift / 32, bits = shift % 32;
+	if (limbs >= a.size()) return magnitude();
+	magnitude result(a.size() - limbs);
+	for (std::size_t i = 0; i < result.size(); ++i)
+	{
+		std::uint64_t x = a[i + limbs] | (i + limbs + 1 < a.size() ? std::uint64_t(a[i + limbs + 1]) << 32 : 0);
+		result[i] = limb(x >> bits);
+	}
+	trim(result);
+	return result;
+}
+
+// a = a / d, returning a % d.
+static limb divide_small(magnitude& a, limb d)
+{
+	std::uint64_t remainder = 0;
+	for (std::size_t i = a.size(); i-- > 0;)
+	{
+		std::uint64_t current = (remainder << 32) | a[i];
+		a[i] = limb(current / d);
+		remainder = current % d;
+	}
+	trim(a);
+	return limb(remainder);
+}
+
+// Long division (Knuth, TAOCP vol. 2, 4.3.1, algorithm D), for divisors of two or more limbs and u >= v.
+static void divide_knuth(const magnitude& u, const magnitude& v, magnitude& q, magnitude& r)
+{
+	const std::uint64_t base = std::uint64_t(1) << 32;
+	const std::size_t m = u.size(), n = v.size();
+	const int s = leading_zeros(v[n - 1]);		// normalise, so the divisor's top limb has its high bit set
+
+	magnitude vn(n), un(m + 1);
+	for (std::size_t i = n - 1; i > 0; --i) vn[i] = limb((v[i] << s) | (std::uint64_t(v[i - 1]) >> (32 - s)));
+	vn[0] = v[0] << s;
+	un[m] = limb(std::uint64_t(u[m - 1]) >> (32 - s));
+	for (std::size_t i = m - 1; i > 0; --i) un[i] = limb((u[i] << s) | (std::uint64_t(u[i - 1]) >> (32 - s)));
+	un[0] = u[0] << s;
+
+	q.assign(m - n + 1, 0);
+	for (std::size_t j = m - n + 1; j-- > 0;)
+	{
+		// Estimate the quotient limb from the top two limbs, then correct it (at most twice).
+		std::uint64_t top = (std::uint64_t(un[j + n]) << 32) | un[j + n - 1];
+		std::uint64_t qhat = top / vn[n - 1];
+		std::uint64_t rhat = top - qhat * vn[n - 1];
+		while (qhat >= base || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2]))
+		{
+			--qhat;
+			rhat += vn[n - 1];
+			if (rhat >= base) break;
+		}
+
+		// Multiply and subtract.
+		std::int64_t borrow = 0, t;
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			std::uint64_t p = qhat * vn[i];
+			t = std::int64_t(un[i + j]) - borrow - std::int64_t(p & 0xFFFFFFFFu);
+			un[i + j] = limb(t);
+			borrow = std::int64_t(p >> 32) - (t >> 32);
+		}
+		t = std::int64_t(un[j + n]) - borrow;
+		un[j + n] = limb(t);
+
+		q[j] = limb(qhat);
+		if (t < 0)		// subtracted too much, add back
+		{
+			--q[j];
+			std::uint64_t carry = 0;
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				carry += std::uint64_t(un[i + j]) + vn[i];
+				un[i + j] = limb(carry);
+				carry >>= 32;
+			}
+			un[j + n] = limb(un[j + n] + carry);
+		}
+	}
+
+	r.assign(n, 0);
+	for (std::size_t i = 0; i < n; ++i) r[i] = limb((un[i] >> s) | (std::uint64_t(un[i + 1]) << (32 - s)));
+	trim(q);
+	trim(r);
+}
+
+static void divide(const magnitude& u, const magnitude& v, magnitude& q, magnitude& r)
+{
+	if (compare(u, v) < 0) { q.clear(); r = u; }
+	else if (v.size() == 1)
+	{
+		q = u;
+		limb remainder = divide_small(q, v[0]);
+		r.clear();
+		if (remainder) r.push_back(remainder);
+	}
+	else divide_knuth(u, v, q, r);
+}
+
+// Return the (up to) 64 bits of a starting at bit shift.
+static std::uint64_t bits_at(const magnitude& a, std::size_t shift)
+{
+	std::size_t k = shift / 32, offset = shift % 32;
+	auto get = [&](std::size_t i) { return i < a.size() ? std::uint64_t(a[i]) : 0; };
+
+	std::uint64_t result = (get(k) | (get(k + 1) << 32)) >> offset;
+	if (offset) result |= get(k + 2) << (64 - offset);
+	return result;
+}
+
+static std::uint64_t to_u64(const magnitude& a)
+{
+	return (a.size() > 0 ? a[0] : 0) | (a.size() > 1 ? std::uint64_t(a[1]) << 32 : 0);
+}
+
+static magnitude from_u64(std::uint64_t x)
+{
+	magnitude result;
+	if (x) result.push_back(limb(x));
+	if (x >> 32) result.push_back(limb(x >> 32));
+	return result;
+}
+
+// Return x u + y v, for single limb cofactors x and y that are known to give a non-negative result.
+static magnitude linear_combination(const magnitude& u, std::int64_t x, const magnitude& v, std::int64_t y)
+{
+	magnitude a = multiply(u, from_u64(x < 0 ? 0 - std::uint64_t(x) : std::uint64_t(x)));
+	magnitude b = multiply(v, from_u64(y < 0 ? 0 - std::uint64_t(y) : std::uint64_t(y)));
+	if ((x < 0) == (y < 0)) return add(a, b);
+	return compare(a, b) >= 0 ? subtract(a, b) : subtract(b, a);
+}
+
+// Lehmer's gcd (Knuth, TAOCP vol. 2, 4.5.2, algorithm L).
+//		Simulates Euclid's algorithm on the leading 32 bits of u and v, and only applies the accumulated
+//		quotients to the full numbers once the simulation becomes unreliable. So most Euclidean steps
+//		cost a single precision division instead of a multi-precision one.
+static magnitude lehmer_gcd(magnitude u, magnitude v)
+{
+	if (compare(u, v) < 0) std::swap(u, v);
+
+	while (v.size() > 2)
+	{
+		std::size_t shift = bit_length(u) > 32 ? bit_length(u) - 32 : 0;
+		std::int64_t a_hat = std::int64_t(bits_at(u, shift));
+		std::int64_t v_hat = std::int64_t(bits_at(v, shift));
+		std::int64_t A = 1, B = 0, C = 0, D = 1;
+
+		while (v_hat + C != 0 && v_hat + D != 0)
+		{
+			std::int64_t q = (a_hat + A) / (v_hat + C);
+			if (q != (a_hat + B) / (v_hat + D)) break;
+			std::int64_t t;
+			t = A - q * C; A = C; C = t;
+			t = B - q * D; B = D; D = t;
+			t = a_hat - q * v_hat; a_hat = v_hat; v_hat = t;
+		}
+
+		if (B == 0)
+		{
+			// No progress from the leading digits: take one full Euclidean step.
+			magnitude q, r;
+			divide(u, v, q, r);
+			u.swap(v);
+			v.swap(r);
+		}
+		else
+		{
+			// u, v = A u + B v, C u + D v (the cofactors of each pair have opposite signs).
+			magnitude t = linear_combination(u, A, v, B);
+			magnitude w = linear_combination(u, C, v, D);
+			u.swap(t);
+			v.swap(w);
+		}
+	}
+
+	// v now fits in 64 bits: one division brings u down too, then finish with the binary gcd.
+	if (v.empty()) return u;
+	magnitude q, r;
+	divide(u, v, q, r);
+	return from_u64(gcd(to_u64(v), to_u64(r)));
+}
+
+// big_int : private
+//------------------------------------------------------------------------------------
+
+void big_int::assign(bool is_negative, magnitude&& m)
+{
+	trim(m);
+	if (m.size() <= 2) { assign_u64(is_negative, to_u64(m)); return; }
+	small = 0;
+	limbs = std::move(m);
+	negative = is_negative;
+}
+
+void big_int::assign_u64(bool is_negative, std::uint64_t m)
+{
+	const std::uint64_t limit = std::uint64_t(1) << 63;
+	if (m < limit || (is_negative && m == limit))
+	{
+		small = is_negative ? std::int64_t(0 - m) : std::int64_t(m);
+		limbs.clear();
+		negative = false;
+	}
+	else
+	{
+		small = 0;
+		limbs = from_u64(m);
+		negative = is_negative;
+	}
+}
+
+magnitude big_int::get_magnitude() const
+{
+	return is_small() ? to_magnitude(small) : limbs;
+}
+
+void big_int::add_slow(const big_int& rhs, bool subtract_rhs)
+{
+	bool lhs_negative = sign() < 0;
+	bool rhs_negative = (rhs.sign() < 0) != subtract_rhs;
+	magnitude a = get_magnitude(), b = rhs.get_magnitude();
+
+	if (lhs_negative == rhs_negative) assign(lhs_negative, add(a, b));
+	else if (compare(a, b) >= 0) assign(lhs_negative, subtract(a, b));
+	else assign(rhs_negative, subtract(b, a));
+}
+
+void big_int::mul_slow(const big_int& rhs)
+{
+	bool result_negative = (sign() < 0) != (rhs.sign() < 0);
+	assign(result_negative, multiply(get_magnitude(), rhs.get_magnitude()));
+}
+
+int big_int::compare_slow(const big_int& lhs, const big_int& rhs)
+{
+	int l = lhs.sign(), r = rhs.sign();
+	if (l != r) return l < r ? -1 : 1;
+	int c = compare(lhs.get_magnitude(), rhs.get_magnitude());
+	return l < 0 ? -c : c;
+}
+
+// big_int : public
+//------------------------------------------------------------------------------------
+
+big_int::big_int(const str& digits) : small(0), limbs(), negative(false)
+{
+	std::size_t i = 0;
+	bool is_negative = false;
+	if (i < digits.size() && (digits[i] == '-' || digits[i] == '+')) is_negative = digits[i++] == '-';
+	if (i == digits.size()) throw std::invalid_argument("big_int: no digits");
+
+	magnitude m;
+	for (; i < digits.size(); ++i)
+	{
+		if (digits[i] < '0' || digits[i] > '9') throw std::invalid_argument("big_int: invalid digit");
+		multiply_add(m, 10, limb(digits[i] - '0'));
+	}
+	assign(is_negative, std::move(m));
+}
+
+std::size_t big_int::bits() const noexcept
+{
+	if (!is_small()) return bit_length(limbs);
+	std::uint64_t m = small < 0 ? 0 - std::uint64_t(small) : std::uint64_t(small);
+	std::size_t n = 0;
+	while (m) { m >>= 1; ++n; }
+	return n;
+}
+
+bool big_int::is_power_of_2() const noexcept
+{
+	if (is_small())
+	{
+		std::uint64_t m = small < 0 ? 0 - std::uint64_t(small) : std::uint64_t(small);
+		return m && !(m & (m - 1));
+	}
+	for (std::size_t i = 0; i + 1 < limbs.size(); ++i) if (limbs[i]) return false;
+	return !(limbs.back() & (limbs.back() - 1));
+}
+
+double big_int::to_double() const
+{
+	if (is_small()) return double(small);
+	double result = 0;
+	for (std::size_t i = limbs.size(); i-- > 0;) result = result * 4294967296.0 + limbs[i];
+	return negative ? -result : result;
+}
+
+str big_int::to_string() const
+{
+	if (is_small()) return std::to_string(small);
+
+	// Peel off 9 decimal digits at a time.
+	magnitude m = limbs;
+	str result;
+	while (!m.empty())
+	{
+		limb chunk = divide_small(m, 1000000000u);
+		for (int i = 0; i < 9 && (!m.empty() || chunk != 0); ++i)
+		{
+			result += char('0' + chunk % 10);
+			chunk /= 10;
+		}
+	}
+	if (negative) result += '-';
+	return str(result.rbegin(), result.rend());
+}
+
+big_int& big_int::negate()
+{
+	if (is_small() && small != INT64_MIN) small = -small;
+	else if (is_small()) assign_u64(false, std::uint64_t(1) << 63);
+	else negative = !negative;
+	return *this;
+}
+
+void big_int::divmod(const big_int& dividend, const big_int& divisor, big_int& quotient, big_int& remainder)
+{
+	if (divisor.sign() == 0) throw std::domain_error("big_int: division by zero");
+
+	if (dividend.is_small() && divisor.is_small() && !(dividend.small == INT64_MIN && divisor.small == -1))
+	{
+		std::int64_t q = dividend.small / divisor.small, r = dividend.small % divisor.small;
+		quotient = q;
+		remainder = r;
+		return;
+	}
+
+	magnitude q, r;
+	divide(dividend.get_magnitude(), divisor.get_magnitude(), q, r);
+	bool dividend_negative = dividend.sign() < 0;
+	quotient.assign(dividend_negative != (divisor.sign() < 0), std::move(q));
+	remainder.assign(dividend_negative, std::move(r));
+}
+
+big_int& big_int::operator /= (const big_int& rhs) { big_int remainder; divmod(*this, rhs, *this, remainder); return *this; }
+big_int& big_int::operator %= (const big_int& rhs) { big_int quotient; divmod(*this, rhs, quotient, *this); return *this; }
+
+big_int& big_int::operator <<= (std::size_t shift) { assign(sign() < 0, shift_left(get_magnitude(), shift)); return *this; }
+big_int& big_int::operator >>= (std::size_t shift) { assign(sign() < 0, shift_right(get_magnitude(), shift)); return *this; }
+
+big_int gcd(const big_int& a, const big_int& b)
+{
+	if (a.is_small() && b.is_small())
+	{
+		std::uint64_t x = a.small < 0 ? 0 - std::uint64_t(a.small) : std::uint64_t(a.small);
+		std::uint64_t y = b.small < 0 ? 0 - std::uint64_t(b.small) : std::uint64_t(b.small);
+		return big_int(gcd(x, y));
+	}
+	big_int result;
+	result.assign(false, lehmer_gcd(a.get_magnitude(), b.get_magnitude()));
+	return result;
+}
+
+std::ostream& operator << (std::ostream& os, const big_int& rhs) {
+	os << rhs.to_string();
+	return os;
+}
+std::istream& operator >> (std::istream& in, big_int& rhs) {
+	str s;
+	in >> s;
+	rhs = big_int(s);
+	return in;
+}
@@ -0,0 +1,474 @@
+#include "stdafx.h"
+#include "bound_array.h"
+#include <climits>
+
+#if HAS_X86_SIMD
+	#include <immintrin.h>
+#endif
+
+//	The kernels come in three versions: scalar, AVX2 (8 floats or ints, or 4 doubles, at a time) and AVX-512 (twice as many).
+//	The vector versions finish any remainder with the scalar version.
+//
+//	The scalar versions apply bound_clamp and wrap_engine, so they are the reference the vector versions must match exactly.
+//	The vector versions rely on the following:
+//		- max(min, x) then min(max, low) is exactly bound_clamp's pair of selects, including for NaN (which is left alone)
+//		  and for -0 and +0, as the instructions return their second operand when the comparison is false.
+//		- IEEE addition, subtraction, multiplication and division round the same in every instruction set.
+//		- most values to wrap are within one range of the limits, and take a single addition or subtraction, as in wrap.h.
+//		  The lanes that are further out, or that land outside of the range after the first step (from rounding),
+//		  are redone with the scalar wrap_engine.
+//		- integer += and -= wrap as wrap_add does (as cyclic<int>), not by adding with wraparound and then wrapping: the
+//		  offsets from min are stepped forwards by rhs reduced into [0, size], which for a scalar rhs is done once per call.
+//		  Lanes of an array rhs of a whole range or more are redone with the scalar wrap_add.
+
+// Scalar kernels
+//------------------------------------------------------------------------------------
+
+// Integer arithmetic is done in unsigned, so wraps round on overflow (as the vector instructions do)
+template <int Op, class T> static inline T scalar_op(T a, T b)
+{
+	if constexpr (std::is_integral<T>::value) {
+		typedef typename std::make_unsigned<T>::type U;
+		if constexpr (Op == op_add) return T(U(a) + U(b));
+		else if constexpr (Op == op_sub) return T(U(a) - U(b));
+		else if constexpr (Op == op_mul) return T(U(a) * U(b));
+		else if constexpr (Op == op_div) return a / b;
+		else return a;
+	}
+	else {
+		if constexpr (Op == op_add) return a + b;
+		else if constexpr (Op == op_sub) return a - b;
+		else if constexpr (Op == op_mul) return a * b;
+		else if constexpr (Op == op_div) return a / b;
+		else return a;
+	}
+}
+
+template <class T> struct clamp_scalar {
+	template <int Op> static void run(T* v, const T* rhs, T scalar, T min, T max, std::size_t n)
+	{
+		for (std::size_t i = 0; i < n; ++i) {
+			T x = scalar_op<Op>(v[i], rhs ? rhs[i] : scalar);
+			bound_clamp::check(x, min, max);
+			v[i] = x;
+		}
+	}
+};
+
+template <class T> struct clamp_lanes_scalar {
+	template <int Op> static void run(T* v, const T* rhs, T scalar, const T* mins, const T* maxs, std::size_t n)
+	{
+		for (std::size_t i = 0; i < n; ++i) {
+			T x = scalar_op<Op>(v[i], rhs ? rhs[i] : scalar);
+			bound_clamp::check(x, mins[i], maxs[i]);
+			v[i] = x;
+		}
+	}
+};
+
+template <class T> struct wrap_scalar {
+	template <int Op> static void run(T* v, const T* rhs, T scalar, T min, T max, std::size_t n)
+	{
+		if constexpr (std::is_integral<T>::value && (Op == op_add || Op == op_sub)) {
+			typedef typename unsigned_of<T>::type U;
+			const U size = U(U(max) - U(min) + 1), step = wrap_step(scalar, size, Op == op_sub);
+			if (rhs) for (std::size_t i = 0; i < n; ++i) v[i] = wrap_add(v[i], rhs[i], min, max, Op == op_sub);
+			else for (std::size_t i = 0; i < n; ++i) v[i] = wrap_advance(v[i], step, min, size);
+		}
+		else {
+			const wrap_engine<T> engine(min, max);
+			for (std::size_t i = 0; i < n; ++i) v[i] = engine(scalar_op<Op>(v[i], rhs ? rhs[i] : scalar));
+		}
+	}
+};
+
+// Call the kernel K specialised for the operation op
+template <class K, class T, class L> static void run_op(T* v, const T* rhs, T scalar, bound_op op, L min, L max, std::size_t n)
+{
+	switch (op) {
+	case op_check: K::template run<op_check>(v, rhs, scalar, min, max, n); break;
+	case op_add:   K::template run<op_add>(v, rhs, scalar, min, max, n); break;
+	case op_sub:   K::template run<op_sub>(v, rhs, scalar, min, max, n); break;
+	case op_mul:   K::template run<op_mul>(v, rhs, scalar, min, max, n); break;
+	case op_div:   K::template run<op_div>(v, rhs, scalar, min, max, n); break;
+	}
+}
+
+#if HAS_X86_SIMD
+
+// AVX2 kernels
+//------------------------------------------------------------------------------------
+//		Each lane type provides the arithmetic, clamp, and the comparisons used by wrap, whose masks are vectors of all ones or zeros.
+
+struct avx2_float {
+	typedef float T; typedef __m256 reg; typedef __m256 mask;
+	static const std::size_t lanes = 8;
+	static TARGET_AVX2 reg load(const T* p) { return _mm256_loadu_ps(p); }
+	static TARGET_AVX2 void store(T* p, reg x) { _mm256_storeu_ps(p, x); }
+	static TARGET_AVX2 reg set1(T x) { return _mm256_set1_ps(x); }
+	static TARGET_AVX2 reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+	static TARGET_AVX2 reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+	static TARGET_AVX2 reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+	static TARGET_AVX2 reg div(reg a, reg b) { return _mm256_div_ps(a, b); }
+	static TARGET_AVX2 reg clamp(reg x, reg min, reg max) { return _mm256_min_ps(max, _mm256_max_ps(min, x)); }
+	static TARGET_AVX2 mask lt(reg a, reg b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static TARGET_AVX2 mask ge(reg a, reg b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+	static TARGET_AVX2 mask both(mask a, mask b) { return _mm256_and_ps(a, b); }
+	static TARGET_AVX2 mask either(mask a, mask b) { return _mm256_or_ps(a, b); }
+	static TARGET_AVX2 reg select(mask m, reg a, reg b) { return _mm256_blendv_ps(a, b, m); }		// b where m is set
+	static TARGET_AVX2 int bits(mask m) { return _mm256_movemask_ps(m); }
+};
+
+struct avx2_double {
+	typedef double T; typedef __m256d reg; typedef __m256d mask;
+	static const std::size_t lanes = 4;
+	static TARGET_AVX2 reg load(const T* p) { return _mm256_loadu_pd(p); }
+	static TARGET_AVX2 void store(T* p, reg x) { _mm256_storeu_pd(p, x); }
+	static TARGET_AVX2 reg set1(T x) { return _mm256_set1_pd(x); }
+	static TARGET_AVX2 reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+	static TARGET_AVX2 reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+	static TARGET_AVX2 reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+	static TARGET_AVX2 reg div(reg a, reg b) { return _mm256_div_pd(a, b); }
+	static TARGET_AVX2 reg clamp(reg x, reg min, reg max) { return _mm256_min_pd(max, _mm256_max_pd(min, x)); }
+	static TARGET_AVX2 mask lt(reg a, reg b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+	static TARGET_AVX2 mask ge(reg a, reg b) { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+	static TARGET_AVX2 mask both(mask a, mask b) { return _mm256_and_pd(a, b); }
+	static TARGET_AVX2 mask either(mask a, mask b) { return _mm256_or_pd(a, b); }
+	static TARGET_AVX2 reg select(mask m, reg a, reg b) { return _mm256_blendv_pd(a, b, m); }
+	static TARGET_AVX2 int bits(mask m) { return _mm256_movemask_pd(m); }
+};
+
+struct avx2_int {
+	typedef int T; typedef __m256i reg; typedef __m256i mask;
+	static const std::size_t lanes = 8;
+	static TARGET_AVX2 reg load(const T* p) { return _mm256_loadu_si256((const __m256i*)p); }
+	static TARGET_AVX2 void store(T* p, reg x) { _mm256_storeu_si256((__m256i*)p, x); }
+	static TARGET_AVX2 reg set1(T x) { return _mm256_set1_epi32(x); }
+	static TARGET_AVX2 reg add(reg a, reg b) { return _mm256_add_epi32(a, b); }
+	static TARGET_AVX2 reg sub(reg a, reg b) { return _mm256_sub_epi32(a, b); }
+	static TARGET_AVX2 reg mul(reg a, reg b) { return _mm256_mullo_epi32(a, b); }
+	static TARGET_AVX2 reg abs(reg a) { return _mm256_abs_epi32(a); }		// of INT_MIN is 2^31, as unsigned
+	static TARGET_AVX2 reg clamp(reg x, reg min, reg max) { return _mm256_min_epi32(max, _mm256_max_epi32(min, x)); }
+	static TARGET_AVX2 mask lt(reg a, reg b) { return _mm256_cmpgt_epi32(b, a); }
+	static TARGET_AVX2 mask ult(reg a, reg b)		// unsigned a < b, by flipping the sign bits
+	{
+		const __m256i sign = _mm256_set1_epi32(INT_MIN);
+		return _mm256_cmpgt_epi32(_mm256_xor_si256(b, sign), _mm256_xor_si256(a, sign));
+	}
+	static TARGET_AVX2 mask both(mask a, mask b) { return _mm256_and_si256(a, b); }
+	static TARGET_AVX2 mask either(mask a, mask b) { return _mm256_or_si256(a, b); }
+	static TARGET_AVX2 mask but_not(mask a, mask b) { return _mm256_andnot_si256(b, a); }
+	static TARGET_AVX2 reg select(mask m, reg a, reg b) { return _mm256_blendv_epi8(a, b, m); }
+	static TARGET_AVX2 int bits(mask m) { return _mm256_movemask_ps(_mm256_castsi256_ps(m)); }
+};
+
+template <int Op, class V> static TARGET_AVX2 inline typename V::reg op_avx2(typename V::reg a, typename V::reg b)
+{
+	if constexpr (Op == op_add) return V::add(a, b);
+	else if constexpr (Op == op_sub) return V::sub(a, b);
+	else if constexpr (Op == op_mul) return V::mul(a, b);
+	else if constexpr (Op == op_div) return V::div(a, b);
+	else return a;
+}
+
+template <class V> struct clamp_avx2 {
+	typedef typename V::T T;
+	template <int Op> static TARGET_AVX2 void run(T* v, const T* rhs, T scalar, T min, T max, std::size_t n)
+	{
+		std::size_t i = 0;
+		if constexpr (!(std::is_integral<T>::value && Op == op_div)) {		// there is no vector integer division
+			const typename V::reg low = V::set1(min), high = V::set1(max), s = V::set1(scalar);
+			for (; i + V::lanes <= n; i += V::lanes) V::store(v + i, V::clamp(op_avx2<Op, V>(V::load(v + i), rhs ? V::load(rhs + i) : s), low, high));
+		}
+		clamp_scalar<T>::template run<Op>(v + i, rhs ? rhs + i : rhs, scalar, min, max, n - i);
+	}
+};
+
+template <class V> struct clamp_lanes_avx2 {
+	typedef typename V::T T;
+	template <int Op> static TARGET_AVX2 void run(T* v, const T* rhs, T scalar, const T* mins, const T* maxs, std::size_t n)
+	{
+		std::size_t i = 0;
+		if constexpr (!(std::is_integral<T>::value && Op == op_div)) {
+			const typename V::reg s = V::set1(scalar);
+			for (; i + V::lanes <= n; i += V::lanes) V::store(v + i, V::clamp(op_avx2<Op, V>(V::load(v + i), rhs ? V::load(rhs + i) : s), V::load(mins + i), V::load(maxs + i)));
+		}
+		clamp_lanes_scalar<T>::template run<Op>(v + i, rhs ? rhs + i : rhs, scalar, mins + i, maxs + i, n - i);
+	}
+};
+
+template <class V> struct wrap_avx2 {
+	typedef typename V::T T;
+	typedef typename V::reg reg;
+	typedef typename V::mask mask;
+
+	template <int Op> static TARGET_AVX2 void run(T* v, const T* rhs, T scalar, T min, T max, std::size_t n)
+	{
+		std::size_t i = 0;
+		const wrap_engine<T> engine(min, max);
+		if constexpr (std::is_integral<T>::value) {
+			const unsigned size = unsigned(max) - unsigned(min) + 1;
+			if (size == 0) { clamp_avx2<V>::template run<Op>(v, rhs, scalar, INT_MIN, INT_MAX, n); return; }		// the range is all of int: nothing to wrap
+			if constexpr (Op == op_add || Op == op_sub) {
+				// As wrap_add: the values are in range, and their offsets from min step forwards by rhs reduced into [0, size]
+				const reg low = V::set1(min), period = V::set1(int(size)), zero = V::set1(0);
+				const reg scalar_step = V::set1(int(wrap_step(scalar, size, Op == op_sub)));
+				for (; i + V::lanes <= n; i += V::lanes) {
+					reg x = V::load(v + i), step = scalar_step;
+					int far = 0;
+					if (rhs) {
+						reg r = V::load(rhs + i), mag = V::abs(r), back = V::sub(period, mag);
+						mask negative = V::lt(r, zero);
+						step = Op == op_add ? V::select(negative, mag, back) : V::select(negative, back, mag);
+						far = ~V::bits(V::ult(mag, period)) & ((1 << V::lanes) - 1);		// a whole range or more
+					}
+					reg rest = V::sub(period, step);		// the offset at which the step passes max
+					reg t = V::select(V::ult(V::sub(x, low), rest), V::sub(x, rest), V::add(x, step));
+					if (far) step_far(v + i, x, t, rhs + i, far, min, max, Op == op_sub);
+					else V::store(v + i, t);
+				}
+			}
+			else if constexpr (Op != op_div) {
+				const reg low = V::set1(min), period = V::set1(int(size)), one = V::set1(1), s = V::set1(scalar);
+				for (; i + V::lanes <= n; i += V::lanes) {
+					reg x = op_avx2<Op, V>(V::load(v + i), rhs ? V::load(rhs + i) : s);
+
+					// As wrap(): values below min, and values at or above it, in unsigned offsets from min
+					mask below = V::lt(x, low);
+					reg offset = V::sub(x, low);
+					mask inside = V::but_not(V::ult(offset, period), below);
+					mask above  = V::but_not(V::ult(V::sub(offset, period), period), V::either(below, inside));		// size <= offset < 2 size
+					mask under  = V::both(V::ult(V::sub(V::sub(low, x), one), period), below);		// 1 <= min - x <= size
+					reg t = V::select(above, x, V::sub(x, period));
+					V::store(v + i, V::select(under, t, V::add(x, period)));
+
+					int far = ~V::bits(V::either(inside, V::either(above, under))) & ((1 << V::lanes) - 1);
+					if (far) finish(v + i, x, far, engine);
+				}
+			}
+		}
+		else {
+			const reg low = V::set1(min), high = V::set1(max), period = V::set1(max - min), s = V::set1(scalar);
+			for (; i + V::lanes <= n; i += V::lanes) {
+				reg x = op_avx2<Op, V>(V::load(v + i), rhs ? V::load(rhs + i) : s);
+
+				// As floating_wrap: one subtraction above, one addition below, and the lanes still outside redone in full
+				mask above = V::ge(x, high), below = V::lt(x, low);
+				reg t = V::select(below, V::select(above, x, V::sub(x, period)), V::add(x, period));
+				V::store(v + i, t);
+
+				int far = V::bits(V::either(V::both(above, V::ge(t, high)), V::both(below, V::either(V::lt(t, low), V::ge(t, high)))));
+				if (far) finish(v + i, x, far, engine);
+			}
+		}
+		wrap_scalar<T>::template run<Op>(v + i, rhs ? rhs + i : rhs, scalar, min, max, n - i);
+	}
+
+	// Store t, then redo the lanes of far from the old values x with the scalar wrap_add
+	static TARGET_AVX2 void step_far(T* v, reg x, reg t, const T* rhs, int far, T min, T max, bool negate)
+	{
+		T old[V::lanes];
+		V::store(old, x);
+		V::store(v, t);
+		for (std::size_t j = 0; j < V::lanes; ++j) if (far & (1 << j)) v[j] = wrap_add(old[j], rhs[j], min, max, negate);
+	}
+
+	// Wrap the lanes of x set in far with the scalar engine
+	static TARGET_AVX2 void finish(T* v, reg x, int far, const wrap_engine<T>& engine)
+	{
+		T lanes[V::lanes];
+		V::store(lanes, x);
+		for (std::size_t j = 0; j < V::lanes; ++j) if (far & (1 << j)) v[j] = engine(lanes[j]);
+	}
+};
+
+// AVX-512 kernels
+//------------------------------------------------------------------------------------
+//		As the AVX2 kernels, with comparisons into mask registers.
+
+struct avx512_float {
+	typedef float T; typedef __m512 reg; typedef __mmask16 mask;
+	static const std::size_t lanes = 16;
+	static TARGET_AVX512 reg load(const T* p) { return _mm512_loadu_ps(p); }
+	static TARGET_AVX512 void store(T* p, reg x) { _mm512_storeu_ps(p, x); }
+	static TARGET_AVX512 reg set1(T x) { return _mm512_set1_ps(x); }
+	static TARGET_AVX512 reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+	static TARGET_AVX512 reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+	static TARGET_AVX512 reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+	static TARGET_AVX512 reg div(reg a, reg b) { return _mm512_div_ps(a, b); }
+	static TARGET_AVX512 reg clamp(reg x, reg min, reg max) { return _mm512_min_ps(max, _mm512_max_ps(min, x)); }
+	static TARGET_AVX512 mask lt(reg a, reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+	static TARGET_AVX512 mask ge(reg a, reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+	static TARGET_AVX512 reg select(mask m, reg a, reg b) { return _mm512_mask_blend_ps(m, a, b); }
+};
+
+struct avx512_double {
+	typedef double T; typedef __m512d reg; typedef __mmask8 mask;
+	static const std::size_t lanes = 8;
+	static TARGET_AVX512 reg load(const T* p) { return _mm512_loadu_pd(p); }
+	static TARGET_AVX512 void store(T* p, reg x) { _mm512_storeu_pd(p, x); }
+	static TARGET_AVX512 reg set1(T x) { return _mm512_set1_pd(x); }
+	static TARGET_AVX512 reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+	static TARGET_AVX512 reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+	static TARGET_AVX512 reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+	static TARGET_AVX512 reg div(reg a, reg b) { return _mm512_div_pd(a, b); }
+	static TARGET_AVX512 reg clamp(reg x, reg min, reg max) { return _mm512_min_pd(max, _mm512_max_pd(min, x)); }
+	static TARGET_AVX512 mask lt(reg a, reg b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+	static TARGET_AVX512 mask ge(reg a, reg b) { return _mm512_cmp_pd_mask(a, b, _CMP_GE_OQ); }
+	static TARGET_AVX512 reg select(mask m, reg a, reg b) { return _mm512_mask_blend_pd(m, a, b); }
+};
+
+struct avx512_int {
+	typedef int T; typedef __m512i reg; typedef __mmask16 mask;
+	static const std::size_t lanes = 16;
+	static TARGET_AVX512 reg load(const T* p) { return _mm512_loadu_si512(p); }
+	static TARGET_AVX512 void store(T* p, reg x) { _mm512_storeu_si512(p, x); }
+	static TARGET_AVX512 reg set1(T x) { return _mm512_set1_epi32(x); }
+	static TARGET_AVX512 reg add(reg a, reg b) { return _mm512_add_epi32(a, b); }
+	static TARGET_AVX512 reg sub(reg a, reg b) { return _mm512_sub_epi32(a, b); }
+	static TARGET_AVX512 reg mul(reg a, reg b) { return _mm512_mullo_epi32(a, b); }
+	static TARGET_AVX512 reg abs(reg a) { return _mm512_abs_epi32(a); }
+	static TARGET_AVX512 reg clamp(reg x, reg min, reg max) { return _mm512_min_epi32(max, _mm512_max_epi32(min, x)); }
+	static TARGET_AVX512 mask lt(reg a, reg b) { return _mm512_cmplt_epi32_mask(a, b); }
+	static TARGET_AVX512 mask ult(reg a, reg b) { return _mm512_cmplt_epu32_mask(a, b); }
+	static TARGET_AVX512 reg select(mask m, reg a, reg b) { return _mm512_mask_blend_epi32(m, a, b); }
+};
+
+template <int Op, class V> static TARGET_AVX512 inline typename V::reg op_avx512(typename V::reg a, typename V::reg b)
+{
+	if constexpr (Op == op_add) return V::add(a, b);
+	else if constexpr (Op == op_sub) return V::sub(a, b);
+	else if constexpr (Op == op_mul) return V::mul(a, b);
+	else if constexpr (Op == op_div) return V::div(a, b);
+	else return a;
+}
+
+template <class V> struct clamp_avx512 {
+	typedef typename V::T T;
+	template <int Op> static TARGET_AVX512 void run(T* v, const T* rhs, T scalar, T min, T max, std::size_t n)
+	{
+		std::size_t i = 0;
+		if constexpr (!(std::is_integral<T>::value && Op == op_div)) {
+			const typename V::reg low = V::set1(min), high = V::set1(max), s = V::set1(scalar);
+			for (; i + V::lanes <= n; i += V::lanes) V::store(v + i, V::clamp(op_avx512<Op, V>(V::load(v + i), rhs ? V::load(rhs + i) : s), low, high));
+		}
+		clamp_scalar<T>::template run<Op>(v + i, rhs ? rhs + i : rhs, scalar, min, max, n - i);
+	}
+};
+
+template <class V> struct clamp_lanes_avx512 {
+	typedef typename V::T T;
+	template <int Op> static TARGET_AVX512 void run(T* v, const T* rhs, T scalar, const T* mins, const T* maxs, std::size_t n)
+	{
+		std::size_t i = 0;
+		if constexpr (!(std::is_integral<T>::value && Op == op_div)) {
+			const typename V::reg s = V::set1(scalar);
+			for (; i + V::lanes <= n; i += V::lanes) V::store(v + i, V::clamp(op_avx512<Op, V>(V::load(v + i), rhs ? V::load(rhs + i) : s), V::load(mins + i), V::load(maxs + i)));
+		}
+		clamp_lanes_scalar<T>::template run<Op>(v + i, rhs ? rhs + i : rhs, scalar, mins + i, maxs + i, n - i);
+	}
+};
+
+template <class V> struct wrap_avx512 {
+	typedef typename V::T T;
+	typedef typename V::reg reg;
+	typedef typename V::mask mask;
+
+	template <int Op> static TARGET_AVX512 void run(T* v, const T* rhs, T scalar, T min, T max, std::size_t n)
+	{
+		std::size_t i = 0;
+		const wrap_engine<T> engine(min, max);
+		if constexpr (std::is_integral<T>::value) {
+			const unsigned size = unsigned(max) - unsigned(min) + 1;
+			if (size == 0) { clamp_avx512<V>::template run<Op>(v, rhs, scalar, INT_MIN, INT_MAX, n); return; }
+			if constexpr (Op == op_add || Op == op_sub) {
+				// As wrap_add: the values are in range, and their offsets from min step forwards by rhs reduced into [0, size]
+				const reg low = V::set1(min), period = V::set1(int(size)), zero = V::set1(0);
+				const reg scalar_step = V::set1(int(wrap_step(scalar, size, Op == op_sub)));
+				for (; i + V::lanes <= n; i += V::lanes) {
+					reg x = V::load(v + i), step = scalar_step;
+					int far = 0;
+					if (rhs) {
+						reg r = V::load(rhs + i), mag = V::abs(r), back = V::sub(period, mag);
+						mask negative = V::lt(r, zero);
+						step = Op == op_add ? V::select(negative, mag, back) : V::select(negative, back, mag);
+						far = ~int(V::ult(mag, period)) & ((1 << V::lanes) - 1);		// a whole range or more
+					}
+					reg rest = V::sub(period, step);		// the offset at which the step passes max
+					reg t = V::select(V::ult(V::sub(x, low), rest), V::sub(x, rest), V::add(x, step));
+					if (far) step_far(v + i, x, t, rhs + i, far, min, max, Op == op_sub);
+					else V::store(v + i, t);
+				}
+			}
+			else if constexpr (Op != op_div) {
+				const reg low = V::set1(min), period = V::set1(int(size)), one = V::set1(1), s = V::set1(scalar);
+				for (; i + V::lanes <= n; i += V::lanes) {
+					reg x = op_avx512<Op, V>(V::load(v + i), rhs ? V::load(rhs + i) : s);
+
+					mask below = V::lt(x, low);
+					reg offset = V::sub(x, low);
+					mask inside = V::ult(offset, period) & ~below;
+					mask above  = V::ult(V::sub(offset, period), period) & ~(below | inside);
+					mask under  = V::ult(V::sub(V::sub(low, x), one), period) & below;
+					reg t = V::select(above, x, V::sub(x, period));
+					V::store(v + i, V::select(under, t, V::add(x, period)));
+
+					int far = ~int(inside | above | under) & ((1 << V::lanes) - 1);
+					if (far) finish(v + i, x, far, engine);
+				}
+			}
+		}
+		else {
+			const reg low = V::set1(min), high = V::set1(max), period = V::set1(max - min), s = V::set1(scalar);
+			for (; i + V::lanes <= n; i += V::lanes) {
+				reg x = op_avx512<Op, V>(V::load(v + i), rhs ? V::load(rhs + i) : s);
+
+				mask above = V::ge(x, high), below = V::lt(x, low);
+				reg t = V::select(below, V::select(above, x, V::sub(x, period)), V::add(x, period));
+				V::store(v + i, t);
+
+				int far = int((above & V::ge(t, high)) | (below & (V::lt(t, low) | V::ge(t, high))));
+				if (far) finish(v + i, x, far, engine);
+			}
+		}
+		wrap_scalar<T>::template run<Op>(v + i, rhs ? rhs + i : rhs, scalar, min, max, n - i);
+	}
+
+	static TARGET_AVX512 void step_far(T* v, reg x, reg t, const T* rhs, int far, T min, T max, bool negate)
+	{
+		T old[V::lanes];
+		V::store(old, x);
+		V::store(v, t);
+		for (std::size_t j = 0; j < V::lanes; ++j) if (far & (1 << j)) v[j] = wrap_add(old[j], rhs[j], min, max, negate);
+	}
+
+	static TARGET_AVX512 void finish(T* v, reg x, int far, const wrap_engine<T>& engine)
+	{
+		T lanes[V::lanes];
+		V::store(lanes, x);
+		for (std::size_t j = 0; j < V::lanes; ++j) if (far & (1 << j)) v[j] = engine(lanes[j]);
+	}
+};
+
+#endif
+
+// Dispatch
+//------------------------------------------------------------------------------------
+
+template <class T> static const bound_kernels<T>& get_kernels(simd_isa isa)
+{
+	static const bound_kernels<T> scalar = { run_op<clamp_scalar<T>, T, T>, run_op<clamp_lanes_scalar<T>, T, const T*>, run_op<wrap_scalar<T>, T, T> };
+#if HAS_X86_SIMD
+	typedef typename std::conditional<std::is_same<T, float>::value, avx2_float, typename std::conditional<std::is_same<T, double>::value, avx2_double, avx2_int>::type>::type V2;
+	typedef typename std::conditional<std::is_same<T, float>::value, avx512_float, typename std::conditional<std::is_same<T, double>::value, avx512_double, avx512_int>::type>::type V512;
+	static const bound_kernels<T> avx2 = { run_op<clamp_avx2<V2>, T, T>, run_op<clamp_lanes_avx2<V2>, T, const T*>, run_op<wrap_avx2<V2>, T, T> };
+	static const bound_kernels<T> avx512 = { run_op<clamp_avx512<V512>, T, T>, run_op<clamp_lanes_avx512<V512>, T, const T*>, run_op<wrap_avx512<V512>, T, T> };
+	if (isa == isa_avx512) return avx512;
+	if (isa == isa_avx2) return avx2;
+#endif
+	return scalar;
+}
+
+template <> const bound_kernels<float>&  bound_kernels<float>::get(simd_isa isa)  { return get_kernels<float>(isa); }
+template <> const bound_kernels<double>& bound_kernels<double>::get(simd_isa isa) { return get_kernels<double>(isa); }
+template <> const bound_kernels<int>&    bound_kernels<int>::get(simd_isa isa)    { return get_kernels<int>(isa); }
@@ -0,0 +1,144 @@
+#include "stdafx.h"
+#include "bound_io.h"
+#include <cstring>
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+static const char bound_magic[8] = { 'B', 'O', 'U', 'N', 'D', 'A', 'R', 'R' };
+static const std::uint32_t native_order = 0x01020304, swapped_order = 0x04030201;
+
+// Headers
+//------------------------------------------------------------------------------------
+
+static std::uint64_t round_up(std::uint64_t bytes) { return (bytes + 63) & ~std::uint64_t(63); }		// to simd_alignment
+
+bound_file_header make_bound_header(std::uint8_t type, std::size_t value_size, std::uint64_t count, std::uint8_t flags)
+{
+	bound_file_header header = {};
+	std::memcpy(header.magic, bound_magic, sizeof(bound_magic));
+	header.byte_order = native_order;
+	header.version = bound_file_version;
+	header.type = type;
+	header.flags = flags;
+	header.count = count;
+	header.values = sizeof(bound_file_header);
+	header.mins = header.values + round_up(count * value_size);
+	header.maxs = header.mins + round_up(((flags & bound_file_lanes) ? count : 1) * value_size);
+	return header;
+}
+
+void check_bound_header(const bound_file_header& header, std::uint8_t type, std::size_t value_size, std::uint64_t file_size)
+{
+	if (std::memcmp(header.magic, bound_magic, sizeof(bound_magic)) != 0) throw std::runtime_error("bound file: not a bound file");
+	if (header.byte_order == swapped_order) throw std::runtime_error("bound file: written on a machine of the other byte order");
+	if (header.byte_order != native_order) throw std::runtime_error("bound file: not a bound file");
+	if (header.version == 0 || header.version > bound_file_version) throw std::runtime_error("bound file: unsupported version " + std::to_string(header.version));
+	if (header.type != type) throw std::runtime_error("bound file: holds a different type of value");
+
+	// The arrays must be aligned, in order, and within the file. Dividing rather than multiplying the count avoids overflow.
+	std::uint64_t limit = file_size < std::uint64_t(SIZE_MAX) ? file_size : std::uint64_t(SIZE_MAX);
+	std::uint64_t ranges = (header.flags & bound_file_lanes) ? header.count : 1;
+	bool fits = header.count <= limit / value_size
+		&& header.values % 64 == 0 && header.mins % 64 == 0 && header.maxs % 64 == 0
+		&& header.values >= sizeof(bound_file_header) && header.values <= limit
+		&& header.mins >= header.values && (header.mins - header.values) / value_size >= header.count
+		&& header.maxs >= header.mins && (header.maxs - header.mins) / value_size >= ranges
+		&& header.maxs <= limit && (limit - header.maxs) / value_size >= ranges;
+	if (!fits) throw std::runtime_error("bound file: truncated or corrupt");
+}
+
+// Memory mapped files
+//------------------------------------------------------------------------------------
+
+#ifdef _WIN32
+
+mapped_file::mapped_file() noexcept : address(nullptr), length(0), mapping(nullptr) {}
+
+mapped_file::mapped_file(const std::string& path) : address(nullptr), length(0), mapping(nullptr)
+{
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("mapped_file: cannot open " + path);
+	LARGE_INTEGER bytes;
+	if (!GetFileSizeEx(file, &bytes)) { CloseHandle(file); throw std::runtime_error("mapped_file: cannot read the size of " + path); }
+	length = std::size_t(bytes.QuadPart);
+	if (length != 0) {
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping) address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	}
+	CloseHandle(file);		// the mapping keeps the file open
+	if (length != 0 && !address) { release(); throw std::runtime_error("mapped_file: cannot map " + path); }
+}
+
+mapped_file::mapped_file(mapped_file&& rhs) noexcept : address(rhs.address), length(rhs.length), mapping(rhs.mapping)
+{
+	rhs.address = nullptr; rhs.length = 0; rhs.mapping = nullptr;
+}
+
+mapped_file& mapped_file::operator = (mapped_file&& rhs) noexcept
+{
+	if (this != &rhs) {
+		release();
+		address = rhs.address; length = rhs.length; mapping = rhs.mapping;
+		rhs.address = nullptr; rhs.length = 0; rhs.mapping = nullptr;
+	}
+	return *this;
+}
+
+void mapped_file::release() noexcept
+{
+	if (address) UnmapViewOfFile(address);
+	if (mapping) CloseHandle(mapping);
+	address = nullptr; length = 0; mapping = nullptr;
+}
+
+#else
+
+mapped_file::mapped_file() noexcept : address(nullptr), length(0) {}
+
+mapped_file::mapped_file(const std::string& path) : address(nullptr), length(0)
+{
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) throw std::runtime_error("mapped_file: cannot open " + path);
+	struct stat status;
+	if (fstat(fd, &status) != 0) { ::close(fd); throw std::runtime_error("mapped_file: cannot read the size of " + path); }
+	length = std::size_t(status.st_size);
+	if (length != 0) {
+		void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p == MAP_FAILED) { ::close(fd); length = 0; throw std::runtime_error("mapped_file: cannot map " + path); }
+		address = p;
+	}
+	::close(fd);		// the mapping keeps the file open
+}
+
+mapped_file::mapped_file(mapped_file&& rhs) noexcept : address(rhs.address), length(rhs.length)
+{
+	rhs.address = nullptr; rhs.length = 0;
+}
+
+mapped_file& mapped_file::operator = (mapped_file&& rhs) noexcept
+{
+	if (this != &rhs) {
+		release();
+		address = rhs.address; length = rhs.length;
+		rhs.address = nullptr; rhs.length = 0;
+	}
+	return *this;
+}
+
+void mapped_file::release() noexcept
+{
+	if (address) munmap(const_cast<void*>(address), length);
+	address = nullptr; length = 0;
+}
+
+#endif
@@ -0,0 +1,105 @@
+#include "stdafx.h"
+#include <stdexcept>
+#include "fraction_accumulator.h"
+
+// Private
+
+std::size_t fraction_accumulator::find(std::int64_t den)
+{
+	std::size_t mask = slots.size() - 1;
+	std::size_t i = hash(den, slots.size());
+	for (; slots[i].den != 0; i = (i + 1) & mask) if (slots[i].den == den) return i;
+
+	// A new group: keep the table at most half full, so that the probes stay short.
+	if (2 * (count + 1) > slots.size()) {
+		if (slots.size() < max_slots) rehash(2 * slots.size());
+		else flush();
+		return find(den);
+	}
+	slots[i].den = den;
+	slots[i].num = 0;
+	++count;
+	return i;
+}
+
+void fraction_accumulator::rehash(std::size_t size)
+{
+	std::vector<group> old(size);
+	old.swap(slots);
+	std::size_t mask = size - 1;
+	for (const group& g : old) {
+		if (g.den == 0) continue;
+		std::size_t i = hash(g.den, size);
+		while (slots[i].den != 0) i = (i + 1) & mask;
+		slots[i] = g;
+	}
+	last = 0;
+}
+
+// Combine the groups as N/L, with L the least common multiple of their denominators: for each group n/d,
+// with g = gcd(L, d), N/L + n/d = (N d/g + n L/g) / (L d/g). The result is normalised once, when it is added to total.
+void fraction_accumulator::flush()
+{
+	if (count == 0) return;
+	big_int n(0), l(1);
+	for (group& g : slots) {
+		if (g.den == 0) continue;
+		if (g.num != 0) {
+			big_int d(g.den);
+			big_int divisor = gcd(l, d);
+			n = n * (d / divisor) + big_int(g.num) * (l / divisor);
+			l *= d / divisor;
+		}
+		g = group();
+	}
+	count = 0;
+	last = 0;
+	total += big_fraction(n, l);
+}
+
+void fraction_accumulator::add_slow(std::int64_t num, std::int64_t den)
+{
+	if (den == 0) throw std::domain_error("fraction_accumulator: zero denominator");
+	if (den < 0) {
+		if (den == INT64_MIN || num == INT64_MIN) { total += big_fraction(big_int(num), big_int(den)); return; }
+		num = -num;
+		den = -den;
+	}
+	add_group(den, num);
+}
+
+void fraction_accumulator::add_group(std::int64_t den, sum_type num)
+{
+	std::size_t i = find(den);
+	sum_type n = 0;
+	if (checked_add(slots[i].num, num, n)) {
+		// The group's numerator is full: move it into total, and start again.
+		total += big_fraction(big_int(slots[i].num), big_int(den));
+		n = num;
+	}
+	slots[i].num = n;
+	last = i;
+}
+
+// Functions
+
+void fraction_accumulator::merge(const fraction_accumulator& rhs)
+{
+	for (const group& g : rhs.slots) if (g.den != 0) add_group(g.den, g.num);
+	total += rhs.total;
+}
+
+void fraction_accumulator::clear()
+{
+	slots.assign(initial_slots, group());
+	count = 0;
+	last = 0;
+	total = big_fraction();
+}
+
+big_fraction fraction_accumulator::sum() const
+{
+	fraction_accumulator copy(*this);
+	copy.flush();
+	return copy.total;
+}
@@ -0,0 +1,379 @@
+#include "stdafx.h"
+#include "fraction_array.h"
+#include <cstring>
+
+#if HAS_X86_SIMD
+	#include <immintrin.h>
+#endif
+
+//	The kernels come in three versions: scalar, AVX2 (8 fractions at a time) and AVX-512 (16 at a time).
+//	The vector versions finish any remainder with the scalar version.
+//
+//	The scalar versions simply apply the scalar fraction operators, so they are the reference the vector
+//	versions must match exactly. The vector versions rely on the following:
+//		- with overflow_wrap, the terms are truncated to 32 bits, so a 32 bit (wrapping) multiply-low is exact.
+//		- the scalar operators add fractions with equal denominators without cross multiplying, so the vector ones blend that case in.
+//		- comparisons cross multiply into 64 bits (vpmuldq), so cannot overflow.
+//		- int to double conversion and IEEE division round the same in every instruction set.
+//		- simplify uses the same binary gcd as gcd.h, and divides through in double precision, which is exact
+//		  for 32 bit integers that are multiples of the divisor.
+
+typedef basic_fraction<int, no_normalize, overflow_wrap> wrap_fraction;
+
+// Scalar kernels
+//------------------------------------------------------------------------------------
+
+struct add_op { static void apply(wrap_fraction& a, const wrap_fraction& b) { a += b; } };
+struct sub_op { static void apply(wrap_fraction& a, const wrap_fraction& b) { a -= b; } };
+struct mul_op { static void apply(wrap_fraction& a, const wrap_fraction& b) { a *= b; } };
+struct div_op { static void apply(wrap_fraction& a, const wrap_fraction& b) { a /= b; } };
+
+template <class Op> static void binary_scalar(const int* an, const int* ad, const int* bn, const int* bd, int* on, int* od, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; ++i) {
+		wrap_fraction f(an[i], ad[i]);
+		Op::apply(f, wrap_fraction(bn[i], bd[i]));
+		on[i] = f.get_num();
+		od[i] = f.get_den();
+	}
+}
+
+static void compare_scalar(const int* an, const int* ad, const int* bn, const int* bd, std::int8_t* out, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; ++i) {
+		wrap_fraction a(an[i], ad[i]), b(bn[i], bd[i]);
+		out[i] = std::int8_t(a < b ? -1 : (b < a ? 1 : 0));
+	}
+}
+
+static void to_double_scalar(const int* num, const int* den, double* out, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; ++i) out[i] = wrap_fraction(num[i], den[i]).to_double();
+}
+
+static void simplify_scalar(int* num, int* den, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; ++i) reduce_terms(num[i], den[i]);
+}
+
+#if HAS_X86_SIMD
+
+// AVX2 kernels
+//------------------------------------------------------------------------------------
+
+struct add_avx2 {
+	typedef add_op scalar;
+	static TARGET_AVX2 void apply(__m256i an, __m256i ad, __m256i bn, __m256i bd, __m256i& n, __m256i& d)
+	{
+		__m256i same = _mm256_cmpeq_epi32(ad, bd);
+		n = _mm256_add_epi32(_mm256_mullo_epi32(an, bd), _mm256_mullo_epi32(bn, ad));
+		d = _mm256_mullo_epi32(ad, bd);
+		n = _mm256_blendv_epi8(n, _mm256_add_epi32(an, bn), same);
+		d = _mm256_blendv_epi8(d, ad, same);
+	}
+};
+struct sub_avx2 {
+	typedef sub_op scalar;
+	static TARGET_AVX2 void apply(__m256i an, __m256i ad, __m256i bn, __m256i bd, __m256i& n, __m256i& d)
+	{
+		__m256i same = _mm256_cmpeq_epi32(ad, bd);
+		n = _mm256_sub_epi32(_mm256_mullo_epi32(an, bd), _mm256_mullo_epi32(bn, ad));
+		d = _mm256_mullo_epi32(ad, bd);
+		n = _mm256_blendv_epi8(n, _mm256_sub_epi32(an, bn), same);
+		d = _mm256_blendv_epi8(d, ad, same);
+	}
+};
+struct mul_avx2 {
+	typedef mul_op scalar;
+	static TARGET_AVX2 void apply(__m256i an, __m256i ad, __m256i bn, __m256i bd, __m256i& n, __m256i& d)
+	{
+		n = _mm256_mullo_epi32(an, bn);
+		d = _mm256_mullo_epi32(ad, bd);
+	}
+};
+struct div_avx2 {
+	typedef div_op scalar;
+	static TARGET_AVX2 void apply(__m256i an, __m256i ad, __m256i bn, __m256i bd, __m256i& n, __m256i& d)
+	{
+		n = _mm256_mullo_epi32(an, bd);
+		d = _mm256_mullo_epi32(ad, bn);
+	}
+};
+
+template <class Op> static TARGET_AVX2 void binary_avx2(const int* an, const int* ad, const int* bn, const int* bd, int* on, int* od, std::size_t n)
+{
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256i num, den;
+		Op::apply(_mm256_loadu_si256((const __m256i*)(an + i)), _mm256_loadu_si256((const __m256i*)(ad + i)),
+				  _mm256_loadu_si256((const __m256i*)(bn + i)), _mm256_loadu_si256((const __m256i*)(bd + i)), num, den);
+		_mm256_storeu_si256((__m256i*)(on + i), num);
+		_mm256_storeu_si256((__m256i*)(od + i), den);
+	}
+	binary_scalar<typename Op::scalar>(an + i, ad + i, bn + i, bd + i, on + i, od + i, n - i);
+}
+
+static TARGET_AVX2 void compare_avx2(const int* an, const int* ad, const int* bn, const int* bd, std::int8_t* out, std::size_t n)
+{
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256i a_n = _mm256_loadu_si256((const __m256i*)(an + i)), a_d = _mm256_loadu_si256((const __m256i*)(ad + i));
+		__m256i b_n = _mm256_loadu_si256((const __m256i*)(bn + i)), b_d = _mm256_loadu_si256((const __m256i*)(bd + i));
+
+		// Cross multiply the even and odd lanes into 64 bits, and take the sign of the difference.
+		__m256i l_even = _mm256_mul_epi32(a_n, b_d), r_even = _mm256_mul_epi32(b_n, a_d);
+		__m256i l_odd = _mm256_mul_epi32(_mm256_srli_epi64(a_n, 32), _mm256_srli_epi64(b_d, 32));
+		__m256i r_odd = _mm256_mul_epi32(_mm256_srli_epi64(b_n, 32), _mm256_srli_epi64(a_d, 32));
+		__m256i c_even = _mm256_sub_epi64(_mm256_cmpgt_epi64(r_even, l_even), _mm256_cmpgt_epi64(l_even, r_even));
+		__m256i c_odd  = _mm256_sub_epi64(_mm256_cmpgt_epi64(r_odd, l_odd), _mm256_cmpgt_epi64(l_odd, r_odd));
+		__m256i c = _mm256_blend_epi32(c_even, _mm256_slli_epi64(c_odd, 32), 0xAA);
+
+		// The cross multiplication flipped the inequality where the denominators have opposite signs.
+		__m256i flip = _mm256_srai_epi32(_mm256_xor_si256(a_d, b_d), 31);
+		c = _mm256_sub_epi32(_mm256_xor_si256(c, flip), flip);
+
+		__m256i bytes = _mm256_packs_epi16(_mm256_packs_epi32(c, c), _mm256_packs_epi32(c, c));
+		int low = _mm256_cvtsi256_si32(bytes), high = _mm256_extract_epi32(bytes, 4);
+		std::memcpy(out + i, &low, 4);
+		std::memcpy(out + i + 4, &high, 4);
+	}
+	compare_scalar(an + i, ad + i, bn + i, bd + i, out + i, n - i);
+}
+
+static TARGET_AVX2 void to_double_avx2(const int* num, const int* den, double* out, std::size_t n)
+{
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m256d x = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(num + i)));
+		__m256d y = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(den + i)));
+		_mm256_storeu_pd(out + i, _mm256_div_pd(x, y));
+	}
+	to_double_scalar(num + i, den + i, out + i, n - i);
+}
+
+// Count trailing zeros of each lane: x & -x is a power of two, so converts to float exactly, and its exponent is the count.
+// Lanes that are 0 give a negative count, which shifts by srlv treat as "shift everything out".
+static TARGET_AVX2 inline __m256i ctz_avx2(__m256i x)
+{
+	__m256i low = _mm256_and_si256(x, _mm256_sub_epi32(_mm256_setzero_si256(), x));
+	__m256i exponent = _mm256_srli_epi32(_mm256_castps_si256(_mm256_cvtepi32_ps(low)), 23);
+	return _mm256_sub_epi32(_mm256_and_si256(exponent, _mm256_set1_epi32(0xFF)), _mm256_set1_epi32(127));
+}
+
+// Binary gcd of unsigned 32 bit lanes (see gcd.h), iterated until every lane is done.
+static TARGET_AVX2 inline __m256i gcd_avx2(__m256i u, __m256i v)
+{
+	const __m256i zero = _mm256_setzero_si256(), one = _mm256_set1_epi32(1);
+	__m256i trivial = _mm256_or_si256(_mm256_cmpeq_epi32(u, zero), _mm256_cmpeq_epi32(v, zero));
+	__m256i either = _mm256_or_si256(u, v);		// the gcd where u or v is 0
+	u = _mm256_blendv_epi8(u, one, trivial);
+	v = _mm256_blendv_epi8(v, one, trivial);
+
+	__m256i shift = ctz_avx2(_mm256_or_si256(u, v));
+	u = _mm256_srlv_epi32(u, ctz_avx2(u));
+	do {
+		__m256i done = _mm256_cmpeq_epi32(v, zero);
+		v = _mm256_srlv_epi32(v, ctz_avx2(v));
+		__m256i lo = _mm256_min_epu32(u, v), hi = _mm256_max_epu32(u, v);
+		u = _mm256_blendv_epi8(lo, u, done);
+		v = _mm256_blendv_epi8(_mm256_sub_epi32(hi, lo), zero, done);
+	} while (!_mm256_testz_si256(v, v));
+
+	return _mm256_blendv_epi8(_mm256_sllv_epi32(u, shift), either, trivial);
+}
+
+// Divide each lane of x by the lane of divisor, where the division is known to be exact.
+static TARGET_AVX2 inline __m256i divide_exact_avx2(__m256i x, __m256i divisor)
+{
+	__m128i low  = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(x)), _mm256_cvtepi32_pd(_mm256_castsi256_si128(divisor))));
+	__m128i high = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(x, 1)), _mm256_cvtepi32_pd(_mm256_extracti128_si256(divisor, 1))));
+	return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+}
+
+static TARGET_AVX2 void simplify_avx2(int* num, int* den, std::size_t n)
+{
+	const __m256i one = _mm256_set1_epi32(1);
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256i x = _mm256_loadu_si256((const __m256i*)(num + i)), y = _mm256_loadu_si256((const __m256i*)(den + i));
+		__m256i divisor = gcd_avx2(_mm256_abs_epi32(x), _mm256_abs_epi32(y));
+		__m256i reducible = _mm256_cmpgt_epi32(divisor, one);		// signed, like reduce_terms: a gcd of 2^31 is left alone
+		if (!_mm256_testz_si256(reducible, reducible)) {
+			divisor = _mm256_blendv_epi8(one, divisor, reducible);
+			x = divide_exact_avx2(x, divisor);
+			y = divide_exact_avx2(y, divisor);
+		}
+		__m256i negative = _mm256_srai_epi32(y, 31);
+		_mm256_storeu_si256((__m256i*)(num + i), _mm256_sub_epi32(_mm256_xor_si256(x, negative), negative));
+		_mm256_storeu_si256((__m256i*)(den + i), _mm256_sub_epi32(_mm256_xor_si256(y, negative), negative));
+	}
+	simplify_scalar(num + i, den + i, n - i);
+}
+
+// AVX-512 kernels
+//------------------------------------------------------------------------------------
+
+struct add_avx512 {
+	typedef add_op scalar;
+	static TARGET_AVX512 void apply(__m512i an, __m512i ad, __m512i bn, __m512i bd, __m512i& n, __m512i& d)
+	{
+		__mmask16 same = _mm512_cmpeq_epi32_mask(ad, bd);
+		n = _mm512_add_epi32(_mm512_mullo_epi32(an, bd), _mm512_mullo_epi32(bn, ad));
+		d = _mm512_mullo_epi32(ad, bd);
+		n = _mm512_mask_add_epi32(n, same, an, bn);
+		d = _mm512_mask_mov_epi32(d, same, ad);
+	}
+};
+struct sub_avx512 {
+	typedef sub_op scalar;
+	static TARGET_AVX512 void apply(__m512i an, __m512i ad, __m512i bn, __m512i bd, __m512i& n, __m512i& d)
+	{
+		__mmask16 same = _mm512_cmpeq_epi32_mask(ad, bd);
+		n = _mm512_sub_epi32(_mm512_mullo_epi32(an, bd), _mm512_mullo_epi32(bn, ad));
+		d = _mm512_mullo_epi32(ad, bd);
+		n = _mm512_mask_sub_epi32(n, same, an, bn);
+		d = _mm512_mask_mov_epi32(d, same, ad);
+	}
+};
+struct mul_avx512 {
+	typedef mul_op scalar;
+	static TARGET_AVX512 void apply(__m512i an, __m512i ad, __m512i bn, __m512i bd, __m512i& n, __m512i& d)
+	{
+		n = _mm512_mullo_epi32(an, bn);
+		d = _mm512_mullo_epi32(ad, bd);
+	}
+};
+struct div_avx512 {
+	typedef div_op scalar;
+	static TARGET_AVX512 void apply(__m512i an, __m512i ad, __m512i bn, __m512i bd, __m512i& n, __m512i& d)
+	{
+		n = _mm512_mullo_epi32(an, bd);
+		d = _mm512_mullo_epi32(ad, bn);
+	}
+};
+
+template <class Op> static TARGET_AVX512 void binary_avx512(const int* an, const int* ad, const int* bn, const int* bd, int* on, int* od, std::size_t n)
+{
+	std::size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m512i num, den;
+		Op::apply(_mm512_loadu_si512(an + i), _mm512_loadu_si512(ad + i), _mm512_loadu_si512(bn + i), _mm512_loadu_si512(bd + i), num, den);
+		_mm512_storeu_si512(on + i, num);
+		_mm512_storeu_si512(od + i, den);
+	}
+	binary_scalar<typename Op::scalar>(an + i, ad + i, bn + i, bd + i, on + i, od + i, n - i);
+}
+
+static TARGET_AVX512 void compare_avx512(const int* an, const int* ad, const int* bn, const int* bd, std::int8_t* out, std::size_t n)
+{
+	const __m512i zero = _mm512_setzero_si512(), plus = _mm512_set1_epi64(1), minus = _mm512_set1_epi64(-1);
+	std::size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m512i a_n = _mm512_loadu_si512(an + i), a_d = _mm512_loadu_si512(ad + i);
+		__m512i b_n = _mm512_loadu_si512(bn + i), b_d = _mm512_loadu_si512(bd + i);
+
+		__m512i l_even = _mm512_mul_epi32(a_n, b_d), r_even = _mm512_mul_epi32(b_n, a_d);
+		__m512i l_odd = _mm512_mul_epi32(_mm512_srli_epi64(a_n, 32), _mm512_srli_epi64(b_d, 32));
+		__m512i r_odd = _mm512_mul_epi32(_mm512_srli_epi64(b_n, 32), _mm512_srli_epi64(a_d, 32));
+		__m512i c_even = _mm512_mask_mov_epi64(_mm512_mask_mov_epi64(zero, _mm512_cmplt_epi64_mask(l_even, r_even), minus), _mm512_cmpgt_epi64_mask(l_even, r_even), plus);
+		__m512i c_odd  = _mm512_mask_mov_epi64(_mm512_mask_mov_epi64(zero, _mm512_cmplt_epi64_mask(l_odd, r_odd), minus), _mm512_cmpgt_epi64_mask(l_odd, r_odd), plus);
+		__m512i c = _mm512_mask_blend_epi32(0xAAAA, c_even, _mm512_slli_epi64(c_odd, 32));
+
+		__m512i flip = _mm512_srai_epi32(_mm512_xor_si512(a_d, b_d), 31);
+		c = _mm512_sub_epi32(_mm512_xor_si512(c, flip), flip);
+		_mm_storeu_si128((__m128i*)(out + i), _mm512_cvtepi32_epi8(c));
+	}
+	compare_scalar(an + i, ad + i, bn + i, bd + i, out + i, n - i);
+}
+
+static TARGET_AVX512 void to_double_avx512(const int* num, const int* den, double* out, std::size_t n)
+{
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m512d x = _mm512_cvtepi32_pd(_mm256_loadu_si256((const __m256i*)(num + i)));
+		__m512d y = _mm512_cvtepi32_pd(_mm256_loadu_si256((const __m256i*)(den + i)));
+		_mm512_storeu_pd(out + i, _mm512_div_pd(x, y));
+	}
+	to_double_scalar(num + i, den + i, out + i, n - i);
+}
+
+static TARGET_AVX512 inline __m512i ctz_avx512(__m512i x)
+{
+	__m512i low = _mm512_and_si512(x, _mm512_sub_epi32(_mm512_setzero_si512(), x));
+	__m512i exponent = _mm512_srli_epi32(_mm512_castps_si512(_mm512_cvtepi32_ps(low)), 23);
+	return _mm512_sub_epi32(_mm512_and_si512(exponent, _mm512_set1_epi32(0xFF)), _mm512_set1_epi32(127));
+}
+
+static TARGET_AVX512 inline __m512i gcd_avx512(__m512i u, __m512i v)
+{
+	const __m512i zero = _mm512_setzero_si512(), one = _mm512_set1_epi32(1);
+	__mmask16 trivial = _mm512_cmpeq_epi32_mask(u, zero) | _mm512_cmpeq_epi32_mask(v, zero);
+	__m512i either = _mm512_or_si512(u, v);
+	u = _mm512_mask_mov_epi32(u, trivial, one);
+	v = _mm512_mask_mov_epi32(v, trivial, one);
+
+	__m512i shift = ctz_avx512(_mm512_or_si512(u, v));
+	u = _mm512_srlv_epi32(u, ctz_avx512(u));
+	__mmask16 active;
+	while ((active = _mm512_test_epi32_mask(v, v)) != 0) {
+		v = _mm512_srlv_epi32(v, ctz_avx512(v));
+		__m512i lo = _mm512_min_epu32(u, v), hi = _mm512_max_epu32(u, v);
+		u = _mm512_mask_mov_epi32(u, active, lo);
+		v = _mm512_maskz_sub_epi32(active, hi, lo);
+	}
+
+	return _mm512_mask_mov_epi32(_mm512_sllv_epi32(u, shift), trivial, either);
+}
+
+static TARGET_AVX512 inline __m512i divide_exact_avx512(__m512i x, __m512i divisor)
+{
+	__m256i low  = _mm512_cvttpd_epi32(_mm512_div_pd(_mm512_cvtepi32_pd(_mm512_castsi512_si256(x)), _mm512_cvtepi32_pd(_mm512_castsi512_si256(divisor))));
+	__m256i high = _mm512_cvttpd_epi32(_mm512_div_pd(_mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(x, 1)), _mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(divisor, 1))));
+	return _mm512_inserti64x4(_mm512_castsi256_si512(low), high, 1);
+}
+
+static TARGET_AVX512 void simplify_avx512(int* num, int* den, std::size_t n)
+{
+	const __m512i zero = _mm512_setzero_si512(), one = _mm512_set1_epi32(1);
+	std::size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m512i x = _mm512_loadu_si512(num + i), y = _mm512_loadu_si512(den + i);
+		__m512i divisor = gcd_avx512(_mm512_abs_epi32(x), _mm512_abs_epi32(y));
+		__mmask16 reducible = _mm512_cmpgt_epi32_mask(divisor, one);
+		if (reducible) {
+			divisor = _mm512_mask_mov_epi32(one, reducible, divisor);
+			x = divide_exact_avx512(x, divisor);
+			y = divide_exact_avx512(y, divisor);
+		}
+		__mmask16 negative = _mm512_cmplt_epi32_mask(y, zero);
+		_mm512_storeu_si512(num + i, _mm512_mask_sub_epi32(x, negative, zero, x));
+		_mm512_storeu_si512(den + i, _mm512_mask_sub_epi32(y, negative, zero, y));
+	}
+	simplify_scalar(num + i, den + i, n - i);
+}
+
+#endif
+
+// Dispatch
+//------------------------------------------------------------------------------------
+
+const fraction_kernels& fraction_kernels::get(simd_isa isa)
+{
+	static const fraction_kernels scalar = {
+		binary_scalar<add_op>, binary_scalar<sub_op>, binary_scalar<mul_op>, binary_scalar<div_op>,
+		compare_scalar, to_double_scalar, simplify_scalar
+	};
+#if HAS_X86_SIMD
+	static const fraction_kernels avx2 = {
+		binary_avx2<add_avx2>, binary_avx2<sub_avx2>, binary_avx2<mul_avx2>, binary_avx2<div_avx2>,
+		compare_avx2, to_double_avx2, simplify_avx2
+	};
+	static const fraction_kernels avx512 = {
+		binary_avx512<add_avx512>, binary_avx512<sub_avx512>, binary_avx512<mul_avx512>, binary_avx512<div_avx512>,
+		compare_avx512, to_double_avx512, simplify_avx512
+	};
+	if (isa == isa_avx512) return avx512;
+	if (isa == isa_avx2) return avx2;
+#endif
+	return scalar;
+}
@@ -0,0 +1,201 @@
+#include "stdafx.h"
+#include "saturating.h"
+
+#if HAS_X86_SIMD
+	#include <immintrin.h>
+#endif
+
+//	The kernels come in three versions: scalar, AVX2 and AVX-512 (32 and 64 bit types: 8 and 16 bit types would need AVX-512 BW,
+//	so use the AVX2 kernels there too). The vector versions finish any remainder with the scalar version.
+//
+//	The scalar versions apply saturate_add and saturate_sub, so they are the reference the vector versions must match exactly.
+//	8 and 16 bit types have saturating instructions. For the others:
+//		- signed: the sum overflowed if it has a different sign to both operands ((a ^ s) & (b ^ s) < 0), and the difference
+//		  if the operands differ in sign and the difference differs from a ((a ^ b) & (a ^ s) < 0). Either way it saturates
+//		  towards the sign of a: max ^ (a >> bits - 1) is max for a >= 0, and min for a < 0.
+//		- unsigned: a + min(b, ~a) cannot overflow, and saturates at max; max(a, b) - b saturates at 0.
+//		  64 bit lanes have no unsigned min or max in AVX2, so compare with the sign bits flipped instead.
+
+// Scalar kernels
+//------------------------------------------------------------------------------------
+
+template <class T> static void add_scalar(const T* a, const T* b, T* out, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; ++i) out[i] = saturate_add(a[i], b[i]);
+}
+
+template <class T> static void sub_scalar(const T* a, const T* b, T* out, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; ++i) out[i] = saturate_sub(a[i], b[i]);
+}
+
+#if HAS_X86_SIMD
+
+// AVX2 kernels
+//------------------------------------------------------------------------------------
+
+template <class T> struct avx2_saturate;
+
+template <> struct avx2_saturate<std::int8_t> {
+	static TARGET_AVX2 __m256i add(__m256i a, __m256i b) { return _mm256_adds_epi8(a, b); }
+	static TARGET_AVX2 __m256i sub(__m256i a, __m256i b) { return _mm256_subs_epi8(a, b); }
+};
+template <> struct avx2_saturate<std::uint8_t> {
+	static TARGET_AVX2 __m256i add(__m256i a, __m256i b) { return _mm256_adds_epu8(a, b); }
+	static TARGET_AVX2 __m256i sub(__m256i a, __m256i b) { return _mm256_subs_epu8(a, b); }
+};
+template <> struct avx2_saturate<std::int16_t> {
+	static TARGET_AVX2 __m256i add(__m256i a, __m256i b) { return _mm256_adds_epi16(a, b); }
+	static TARGET_AVX2 __m256i sub(__m256i a, __m256i b) { return _mm256_subs_epi16(a, b); }
+};
+template <> struct avx2_saturate<std::uint16_t> {
+	static TARGET_AVX2 __m256i add(__m256i a, __m256i b) { return _mm256_adds_epu16(a, b); }
+	static TARGET_AVX2 __m256i sub(__m256i a, __m256i b) { return _mm256_subs_epu16(a, b); }
+};
+template <> struct avx2_saturate<std::int32_t> {
+	static TARGET_AVX2 __m256i limit(__m256i a) { return _mm256_xor_si256(_mm256_set1_epi32(INT32_MAX), _mm256_srai_epi32(a, 31)); }
+	static TARGET_AVX2 __m256i select(__m256i s, __m256i a, __m256i overflow)		// the limit where the sign bit of overflow is set
+	{
+		return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(s), _mm256_castsi256_ps(limit(a)), _mm256_castsi256_ps(overflow)));
+	}
+	static TARGET_AVX2 __m256i add(__m256i a, __m256i b)
+	{
+		__m256i s = _mm256_add_epi32(a, b);
+		return select(s, a, _mm256_and_si256(_mm256_xor_si256(a, s), _mm256_xor_si256(b, s)));
+	}
+	static TARGET_AVX2 __m256i sub(__m256i a, __m256i b)
+	{
+		__m256i s = _mm256_sub_epi32(a, b);
+		return select(s, a, _mm256_and_si256(_mm256_xor_si256(a, b), _mm256_xor_si256(a, s)));
+	}
+};
+template <> struct avx2_saturate<std::uint32_t> {
+	static TARGET_AVX2 __m256i add(__m256i a, __m256i b) { return _mm256_add_epi32(a, _mm256_min_epu32(b, _mm256_xor_si256(a, _mm256_set1_epi32(-1)))); }
+	static TARGET_AVX2 __m256i sub(__m256i a, __m256i b) { return _mm256_sub_epi32(_mm256_max_epu32(a, b), b); }
+};
+template <> struct avx2_saturate<std::int64_t> {
+	static TARGET_AVX2 __m256i limit(__m256i a) { return _mm256_xor_si256(_mm256_set1_epi64x(INT64_MAX), _mm256_cmpgt_epi64(_mm256_setzero_si256(), a)); }
+	static TARGET_AVX2 __m256i select(__m256i s, __m256i a, __m256i overflow)
+	{
+		return _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(s), _mm256_castsi256_pd(limit(a)), _mm256_castsi256_pd(overflow)));
+	}
+	static TARGET_AVX2 __m256i add(__m256i a, __m256i b)
+	{
+		__m256i s = _mm256_add_epi64(a, b);
+		return select(s, a, _mm256_and_si256(_mm256_xor_si256(a, s), _mm256_xor_si256(b, s)));
+	}
+	static TARGET_AVX2 __m256i sub(__m256i a, __m256i b)
+	{
+		__m256i s = _mm256_sub_epi64(a, b);
+		return select(s, a, _mm256_and_si256(_mm256_xor_si256(a, b), _mm256_xor_si256(a, s)));
+	}
+};
+template <> struct avx2_saturate<std::uint64_t> {
+	static TARGET_AVX2 __m256i less(__m256i a, __m256i b)		// unsigned a < b, in every bit of the lane
+	{
+		const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+		return _mm256_cmpgt_epi64(_mm256_xor_si256(b, sign), _mm256_xor_si256(a, sign));
+	}
+	static TARGET_AVX2 __m256i add(__m256i a, __m256i b) { __m256i s = _mm256_add_epi64(a, b); return _mm256_or_si256(s, less(s, a)); }
+	static TARGET_AVX2 __m256i sub(__m256i a, __m256i b) { return _mm256_andnot_si256(less(a, b), _mm256_sub_epi64(a, b)); }
+};
+
+template <class T, bool Add> static TARGET_AVX2 void binary_avx2(const T* a, const T* b, T* out, std::size_t n)
+{
+	const std::size_t lanes = sizeof(__m256i) / sizeof(T);
+	std::size_t i = 0;
+	for (; i + lanes <= n; i += lanes) {
+		__m256i x = _mm256_loadu_si256((const __m256i*)(a + i)), y = _mm256_loadu_si256((const __m256i*)(b + i));
+		_mm256_storeu_si256((__m256i*)(out + i), Add ? avx2_saturate<T>::add(x, y) : avx2_saturate<T>::sub(x, y));
+	}
+	if (Add) add_scalar(a + i, b + i, out + i, n - i);
+	else sub_scalar(a + i, b + i, out + i, n - i);
+}
+
+// AVX-512 kernels
+//------------------------------------------------------------------------------------
+
+template <class T> struct avx512_saturate;
+
+template <> struct avx512_saturate<std::int32_t> {
+	static TARGET_AVX512 __m512i select(__m512i s, __m512i a, __m512i overflow)
+	{
+		__m512i limit = _mm512_xor_si512(_mm512_set1_epi32(INT32_MAX), _mm512_srai_epi32(a, 31));
+		return _mm512_mask_blend_epi32(_mm512_cmplt_epi32_mask(overflow, _mm512_setzero_si512()), s, limit);
+	}
+	static TARGET_AVX512 __m512i add(__m512i a, __m512i b)
+	{
+		__m512i s = _mm512_add_epi32(a, b);
+		return select(s, a, _mm512_and_si512(_mm512_xor_si512(a, s), _mm512_xor_si512(b, s)));
+	}
+	static TARGET_AVX512 __m512i sub(__m512i a, __m512i b)
+	{
+		__m512i s = _mm512_sub_epi32(a, b);
+		return select(s, a, _mm512_and_si512(_mm512_xor_si512(a, b), _mm512_xor_si512(a, s)));
+	}
+};
+template <> struct avx512_saturate<std::uint32_t> {
+	static TARGET_AVX512 __m512i add(__m512i a, __m512i b) { return _mm512_add_epi32(a, _mm512_min_epu32(b, _mm512_xor_si512(a, _mm512_set1_epi32(-1)))); }
+	static TARGET_AVX512 __m512i sub(__m512i a, __m512i b) { return _mm512_sub_epi32(_mm512_max_epu32(a, b), b); }
+};
+template <> struct avx512_saturate<std::int64_t> {
+	static TARGET_AVX512 __m512i select(__m512i s, __m512i a, __m512i overflow)
+	{
+		__m512i limit = _mm512_xor_si512(_mm512_set1_epi64(INT64_MAX), _mm512_srai_epi64(a, 63));
+		return _mm512_mask_blend_epi64(_mm512_cmplt_epi64_mask(overflow, _mm512_setzero_si512()), s, limit);
+	}
+	static TARGET_AVX512 __m512i add(__m512i a, __m512i b)
+	{
+		__m512i s = _mm512_add_epi64(a, b);
+		return select(s, a, _mm512_and_si512(_mm512_xor_si512(a, s), _mm512_xor_si512(b, s)));
+	}
+	static TARGET_AVX512 __m512i sub(__m512i a, __m512i b)
+	{
+		__m512i s = _mm512_sub_epi64(a, b);
+		return select(s, a, _mm512_and_si512(_mm512_xor_si512(a, b), _mm512_xor_si512(a, s)));
+	}
+};
+template <> struct avx512_saturate<std::uint64_t> {
+	static TARGET_AVX512 __m512i add(__m512i a, __m512i b) { return _mm512_add_epi64(a, _mm512_min_epu64(b, _mm512_xor_si512(a, _mm512_set1_epi64(-1)))); }
+	static TARGET_AVX512 __m512i sub(__m512i a, __m512i b) { return _mm512_sub_epi64(_mm512_max_epu64(a, b), b); }
+};
+
+template <class T, bool Add> static TARGET_AVX512 void binary_avx512(const T* a, const T* b, T* out, std::size_t n)
+{
+	const std::size_t lanes = sizeof(__m512i) / sizeof(T);
+	std::size_t i = 0;
+	for (; i + lanes <= n; i += lanes) {
+		__m512i x = _mm512_loadu_si512(a + i), y = _mm512_loadu_si512(b + i);
+		_mm512_storeu_si512(out + i, Add ? avx512_saturate<T>::add(x, y) : avx512_saturate<T>::sub(x, y));
+	}
+	if (Add) add_scalar(a + i, b + i, out + i, n - i);
+	else sub_scalar(a + i, b + i, out + i, n - i);
+}
+
+#endif
+
+// Dispatch
+//------------------------------------------------------------------------------------
+
+template <class T> static const saturating_kernels<T>& get_kernels(simd_isa isa)
+{
+	static const saturating_kernels<T> scalar = { add_scalar<T>, sub_scalar<T> };
+#if HAS_X86_SIMD
+	static const saturating_kernels<T> avx2 = { binary_avx2<T, true>, binary_avx2<T, false> };
+	if constexpr (sizeof(T) >= sizeof(std::int32_t)) {
+		static const saturating_kernels<T> avx512 = { binary_avx512<T, true>, binary_avx512<T, false> };
+		if (isa == isa_avx512) return avx512;
+	}
+	if (isa >= isa_avx2) return avx2;
+#endif
+	return scalar;
+}
+
+template <> const saturating_kernels<std::int8_t>&   saturating_kernels<std::int8_t>::get(simd_isa isa)   { return get_kernels<std::int8_t>(isa); }
+template <> const saturating_kernels<std::int16_t>&  saturating_kernels<std::int16_t>::get(simd_isa isa)  { return get_kernels<std::int16_t>(isa); }
+template <> const saturating_kernels<std::int32_t>&  saturating_kernels<std::int32_t>::get(simd_isa isa)  { return get_kernels<std::int32_t>(isa); }
+template <> const saturating_kernels<std::int64_t>&  saturating_kernels<std::int64_t>::get(simd_isa isa)  { return get_kernels<std::int64_t>(isa); }
+template <> const saturating_kernels<std::uint8_t>&  saturating_kernels<std::uint8_t>::get(simd_isa isa)  { return get_kernels<std::uint8_t>(isa); }
+template <> const saturating_kernels<std::uint16_t>& saturating_kernels<std::uint16_t>::get(simd_isa isa) { return get_kernels<std::uint16_t>(isa); }
+template <> const saturating_kernels<std::uint32_t>& saturating_kernels<std::uint32_t>::get(simd_isa isa) { return get_kernels<std::uint32_t>(isa); }
+template <> const saturating_kernels<std::uint64_t>& saturating_kernels<std::uint64_t>::get(simd_isa isa) { return get_kernels<std::uint64_t>(isa); }
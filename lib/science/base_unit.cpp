@@ -1,76 +1,148 @@
 #include "stdafx.h"
 #include "base_unit.h"
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
 
-base_unit::base_unit() noexcept : unit(), power() {}
-base_unit::base_unit(const str &unit, const fraction &power) : unit(unit), power(power) {}
-base_unit::base_unit(const str &unit, const int &power) : unit(unit), power(power, 1) {}
-base_unit::base_unit(const str &str_unit)
+// Symbols
+//------------------------------------------------------------------------------------
+
+// The pre-assigned symbols, in their canonical order: the SI base units (as dense_unit's lanes), then the common derived units
+static const char* const fixed_symbols[] = { "", "kg", "m", "s", "A", "K", "mol", "cd",
+	"g", "Hz", "N", "Pa", "J", "W", "C", "V", "F", "ohm", "S", "Wb", "T", "H", "eV", "u", "rad", "sr" };
+
+const symbol_id symbol_registry::fixed = symbol_id(sizeof(fixed_symbols) / sizeof(fixed_symbols[0]));
+
+symbol_registry::symbol_registry()
 {
-	int pos_pow = str_unit.find("^");
-	if (pos_pow == -1) { unit = str_unit; power = 1; }
-	else {
-		unit = str_unit.substr(0, pos_pow);
-		str p = str_unit.substr(pos_pow + 1);
-
-		// The power could be a fraction or an int
-		int pos_div = p.find("/");
-		if (pos_div == -1) { power = std::stoi(p); }
-		else {
-			power = fraction(std::stoi(p.substr(0, pos_div)), std::stoi(p.substr(pos_div + 1)));
-		}
+	for (const char* symbol : fixed_symbols) {
+		ids.emplace(symbol, symbol_id(names.size()));
+		names.emplace_back(symbol);
+	}
+}
+
+symbol_registry& symbol_registry::instance() { static symbol_registry registry; return registry; }
+
+symbol_id symbol_registry::intern(const str &name)
+{
+	{
+		std::shared_lock<std::shared_mutex> lock(mutex);
+		auto found = ids.find(name);
+		if (found != ids.end()) return found->second;
 	}
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	auto found = ids.find(name);		// another thread may have added it
+	if (found != ids.end()) return found->second;
+	if (names.size() > std::size_t(std::numeric_limits<symbol_id>::max())) throw std::length_error("symbol_registry: too many symbols");
+	symbol_id id = symbol_id(names.size());
+	names.push_back(name);
+	ids.emplace(name, id);
+	return id;
 }
 
+const str& symbol_registry::name(symbol_id id) const
+{
+	std::shared_lock<std::shared_mutex> lock(mutex);
+	if (id >= names.size()) throw std::out_of_range("symbol_registry: unknown symbol id");
+	return names[id];
+}
+
+std::size_t symbol_registry::size() const
+{
+	std::shared_lock<std::shared_mutex> lock(mutex);
+	return names.size();
+}
+
+// Only a symbol outside the fixed set looks up its name (and takes the shared lock)
+bool symbol_registry::before(symbol_id a, symbol_id b) const
+{
+	if (a == b) return false;
+	if (a < fixed || b < fixed) return a < b;		// a fixed id is before any other
+	std::shared_lock<std::shared_mutex> lock(mutex);
+	return names.at(a) < names.at(b);
+}
+
+// FNV-1a of the name
+std::uint64_t symbol_registry::stable_hash(symbol_id id) const
+{
+	if (id < fixed) return id;
+	std::uint64_t h = 0xCBF29CE484222325ull;
+	for (char c : name(id)) h = (h ^ std::uint8_t(c)) * 0x100000001B3ull;
+	return h;
+}
+
+// Base units
+//------------------------------------------------------------------------------------
+
+static_assert(std::is_trivially_copyable<base_unit>::value, "base_unit should be trivially copyable");
+
+base_unit::base_unit() noexcept : id(0), power() {}
+base_unit::base_unit(symbol_id id, const fraction &power) noexcept : id(id), power(power) {}
+base_unit::base_unit(const str &unit, const fraction &power) : id(symbol_registry::instance().intern(unit)), power(power) {}
+base_unit::base_unit(const str &unit, const int &power) : id(symbol_registry::instance().intern(unit)), power(power, 1) {}
+base_unit::base_unit(const str &str_unit) : id(0), power() { set(str_unit); }
+
 // Accessors
 
-	  str& base_unit::get_unit() { return unit; }
-const str& base_unit::get_unit() const { return unit; }
+symbol_id base_unit::get_id() const noexcept { return id; }
+const str& base_unit::get_unit() const { return symbol_registry::instance().name(id); }
 	  fraction& base_unit::get_power() { return power; }
 const fraction& base_unit::get_power() const { return power; }
 
-void base_unit::set(const str &Unit, const fraction &Power) { unit = Unit; power = Power; }
+void base_unit::set(const str &Unit, const fraction &Power) { id = symbol_registry::instance().intern(Unit); power = Power; }
 void base_unit::set(const str &str_unit) {
-	int pos_pow = str_unit.find("^");
-	if (pos_pow == -1) { unit = str_unit; power = 1; }
-	else {
-		unit = str_unit.substr(0, pos_pow);
-		str p = str_unit.substr(pos_pow + 1);
-
-		// The power could be a fraction or an int
-		int pos_div = p.find("/");
-		if (pos_div == -1) { power = std::stoi(p); }
-		else {
-			power = fraction(std::stoi(p.substr(0, pos_div)), std::stoi(p.substr(pos_div + 1)));
-		}
-	}
+	std::size_t pos_pow = str_unit.find('^');
+	if (pos_pow == str::npos) { set_unit(str_unit); power = 1; return; }
+
+	// The power could be a fraction or an int
+	fraction p;
+	const char* last = str_unit.data() + str_unit.size();
+	std::from_chars_result result = from_chars(str_unit.data() + pos_pow + 1, last, p);
+	if (result.ec != std::errc() || result.ptr != last) throw std::invalid_argument("base_unit: bad power in " + str_unit);
+	set_unit(str_unit.substr(0, pos_pow));
+	power = p;
 }
-void base_unit::set_unit(const str &Unit) { unit = Unit; }
+void base_unit::set_unit(const str &Unit) { id = symbol_registry::instance().intern(Unit); }
 void base_unit::set_power(const fraction &Power) { power = Power; }
 
 // Functions
 
+// Units can only be raised to rational powers, so a double power must be exactly a fraction of ints,
+// i.e. a whole number or a fraction with a power of two denominator, e.g. 2.0, 0.5 or -1.25.
+fraction base_unit::to_power(double p)
+{
+	int exponent = 0;
+	long long n = (long long)std::ldexp(std::frexp(p, &exponent), 53);		// p = n / 2^shift exactly
+	int shift = 53 - exponent;
+	while (shift > 0 && n % 2 == 0) { n /= 2; --shift; }
+	if (shift < 0 || shift > 30 || !fits<int>(n)) throw std::domain_error("unit power is not a fraction: " + std::to_string(p));
+	return fraction(int(n), 1 << shift);
+}
+
 void base_unit::invert() { power.negate(); }
-base_unit& base_unit::sqrt() { power /= 2;	return *this; }
+base_unit& base_unit::pow(const fraction &p) { power *= p; power.simplify(); return *this; }
+base_unit& base_unit::sqrt() { power /= 2; power.simplify(); return *this; }
 
 // Type casts
 
 str base_unit::to_string() const
 {
 	if (power == 0) return "";
-	else if (power == 1) return unit;
-	else return unit + "^" + power.to_string();
+	else if (power == 1) return get_unit();
+	else return get_unit() + "^" + power.to_string();
 }
 
 // Operator overloads
 
-bool base_unit::operator == (const base_unit& rhs) const { return (unit == rhs.unit) && (power == rhs.power); }
+bool base_unit::operator == (const base_unit& rhs) const { return id == rhs.id && power == rhs.power; }
 bool base_unit::operator != (const base_unit& rhs) const { return !operator==(rhs); }
-bool base_unit::operator <  (const base_unit& rhs) const { EQ(unit, rhs.unit); return power < rhs.power; }
-bool base_unit::operator >  (const base_unit& rhs) const { EQ(unit, rhs.unit); return power > rhs.power; }
+bool base_unit::operator <  (const base_unit& rhs) const { EQ(id, rhs.id); return power < rhs.power; }
+bool base_unit::operator >  (const base_unit& rhs) const { EQ(id, rhs.id); return power > rhs.power; }
 bool base_unit::operator <= (const base_unit& rhs) const { return !operator>(rhs); }
 bool base_unit::operator >= (const base_unit& rhs) const { return !operator<(rhs); }
 
-base_unit  base_unit::operator -() const { return base_unit(unit, -power); }
+base_unit  base_unit::operator -() const { return base_unit(id, -power); }
 base_unit& base_unit::operator++() { ++power; return *this; }
 base_unit& base_unit::operator--() { --power; return *this; }
 const base_unit base_unit::operator++(int unused) {
@@ -84,11 +156,10 @@ const base_unit base_unit::operator--(int unused) {
 	return result;
 }
 
-base_unit& base_unit::operator  = (base_unit& rhs) { unit = rhs.unit; power = rhs.power; return *this; }
-base_unit& base_unit::operator += (const base_unit& rhs) { EQ(unit, rhs.unit); return *this; }
-base_unit& base_unit::operator -= (const base_unit& rhs) { EQ(unit, rhs.unit); return *this; }
-base_unit& base_unit::operator *= (const base_unit& rhs) { EQ(unit, rhs.unit); power += rhs.power; return *this; }
-base_unit& base_unit::operator /= (const base_unit& rhs) { EQ(unit, rhs.unit); power -= rhs.power; return *this; }
+base_unit& base_unit::operator += (const base_unit& rhs) { EQ(id, rhs.id); return *this; }
+base_unit& base_unit::operator -= (const base_unit& rhs) { EQ(id, rhs.id); return *this; }
+base_unit& base_unit::operator *= (const base_unit& rhs) { EQ(id, rhs.id); power += rhs.power; return *this; }
+base_unit& base_unit::operator /= (const base_unit& rhs) { EQ(id, rhs.id); power -= rhs.power; return *this; }
 
 // Operator overloads : rhs arithmetic
 
@@ -104,25 +175,7 @@ std::ostream& operator << (std::ostream& os, const base_unit& rhs) {
 std::istream& operator >> (std::istream& in, base_unit& rhs) {
 	str s;
 	getline(in, s);
-
-	int position = s.find("^");
-	if (position == -1)
-	{
-		rhs.set_unit(s);
-		rhs.set_power(fraction(1, 1));
-	}
-	else {
-		rhs.set_unit(s.substr(0, position));
-		s = s.substr(position);
-
-		position = s.find("/");
-		if (position == -1) rhs.set_power(fraction(std::stoi(s), 1));
-		else
-		{
-			rhs.set_power(fraction(std::stoi(s.substr(0, position)), std::stoi(s.substr(position))));
-		}
-	}
-
+	rhs.set(s);
 	return in;
 }
 
@@ -0,0 +1,201 @@
+#include "stdafx.h"
+#include "dense_unit.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+static const char* const dimension_symbols[dim_count] = { "kg", "m", "s", "A", "K", "mol", "cd" };
+
+// The power p as a lane (p times 256), or throws if it is not a multiple of 1/256 in range
+static dense_unit::exponent to_lane(long long num, long long den)
+{
+	if (den < 0) { num = -num; den = -den; }
+	long long v = num * dense_unit::one;
+	if (v % den != 0) throw std::domain_error("dense_unit: power is not a multiple of 1/256");
+	v /= den;
+	if (v < -32768 || v > 32767) throw std::overflow_error("dense_unit: power out of range");
+	return dense_unit::exponent(v);
+}
+
+// Symbols
+//------------------------------------------------------------------------------------
+
+static std::unordered_map<symbol_id, dense_unit>& symbol_table()
+{
+	static std::unordered_map<symbol_id, dense_unit> table = [] {
+		std::unordered_map<symbol_id, dense_unit> t;
+		auto add = [&t](const char* symbol, const dense_unit& u) { t[symbol_registry::instance().intern(symbol)] = u; };
+
+		add("", dense_unit());
+		add("kg", dense_unit(1, 0, 0));
+		add("m", dense_unit(0, 1, 0));
+		add("s", dense_unit(0, 0, 1));
+		add("A", dense_unit(0, 0, 0, 1));
+		add("K", dense_unit(0, 0, 0, 0, 1));
+		add("mol", dense_unit(0, 0, 0, 0, 0, 1));
+		add("cd", dense_unit(0, 0, 0, 0, 0, 0, 1));
+
+		add("g", dense_unit(1, 0, 0, 0, 0, 0, 0, 1e-3));
+		add("Hz", dense_unit(0, 0, -1));
+		add("N", dense_unit(1, 1, -2));
+		add("Pa", dense_unit(1, -1, -2));
+		add("J", dense_unit(1, 2, -2));
+		add("W", dense_unit(1, 2, -3));
+		add("C", dense_unit(0, 0, 1, 1));
+		add("V", dense_unit(1, 2, -3, -1));
+		add("ohm", dense_unit(1, 2, -3, -2));
+		add("F", dense_unit(-1, -2, 4, 2));
+		add("T", dense_unit(1, 0, -2, -1));
+		add("Wb", dense_unit(1, 2, -2, -1));
+		add("H", dense_unit(1, 2, -2, -2));
+		add("S", dense_unit(-1, -2, 3, 2));
+		add("rad", dense_unit());
+		add("sr", dense_unit());
+		add("eV", dense_unit(1, 2, -2, 0, 0, 0, 0, 1.602176634e-19));
+
+		// The other units of the constant:: table (with its values of u and E_h)
+		add("u", dense_unit(1, 0, 0, 0, 0, 0, 0, 1.66053904e-27));
+		add("E_h", dense_unit(1, 2, -2, 0, 0, 0, 0, 4.35974465e-18));
+		add("c", dense_unit(0, 1, -1, 0, 0, 0, 0, 299792458));
+		add("C_90", dense_unit(0, 0, 1, 1, 0, 0, 0, 1.0000000805758265));		// K_J-90 R_K-90 / (K_J R_K) C, from the same CODATA values
+		return t;
+	}();
+	return table;
+}
+
+void dense_unit::define(const str& symbol, const dense_unit& u) { symbol_table()[symbol_registry::instance().intern(symbol)] = u; }
+
+static const struct { const char* prefix; double scale; } si_prefixes[] = {
+	{ "da", 1e1 }, { "Y", 1e24 }, { "Z", 1e21 }, { "E", 1e18 }, { "P", 1e15 }, { "T", 1e12 }, { "G", 1e9 }, { "M", 1e6 }, { "k", 1e3 }, { "h", 1e2 },
+	{ "d", 1e-1 }, { "c", 1e-2 }, { "m", 1e-3 }, { "u", 1e-6 }, { "\xC2\xB5", 1e-6 }, { "n", 1e-9 }, { "p", 1e-12 }, { "f", 1e-15 }, { "a", 1e-18 }, { "z", 1e-21 }, { "y", 1e-24 }
+};
+
+// A symbol that is not in the table, as a quotient of two symbols (e.g. MeV/c), or an SI prefix on one that is (e.g. MeV, fm).
+// Nothing is added to the table, which is not locked, so this is as thread safe as a lookup.
+static bool resolve(const str& symbol, dense_unit& u)
+{
+	const std::unordered_map<symbol_id, dense_unit>& table = symbol_table();
+	auto found = table.find(symbol_registry::instance().intern(symbol));
+	if (found != table.end()) { u = found->second; return true; }
+
+	std::size_t slash = symbol.find('/');
+	if (slash != str::npos) {
+		dense_unit den;
+		if (!resolve(symbol.substr(0, slash), u) || !resolve(symbol.substr(slash + 1), den)) return false;
+		u /= den;
+		return true;
+	}
+	for (const auto& p : si_prefixes) {
+		std::size_t n = std::strlen(p.prefix);
+		if (symbol.size() <= n || symbol.compare(0, n, p.prefix) != 0) continue;
+		found = table.find(symbol_registry::instance().intern(symbol.substr(n)));
+		if (found != table.end()) { u = found->second; u.set_scale(u.get_scale() * p.scale); return true; }
+	}
+	return false;
+}
+
+dense_unit dense_unit::lookup(symbol_id id)
+{
+	const std::unordered_map<symbol_id, dense_unit>& table = symbol_table();
+	auto found = table.find(id);
+	if (found != table.end()) return found->second;
+
+	const str& symbol = symbol_registry::instance().name(id);
+	dense_unit u;
+	if (!resolve(symbol, u)) throw std::domain_error("dense_unit: undefined unit " + symbol);
+	return u;
+}
+
+dense_unit dense_unit::lookup(const str& symbol) { return lookup(symbol_registry::instance().intern(symbol)); }
+
+// Construction
+//------------------------------------------------------------------------------------
+
+dense_unit::dense_unit(int mass, int length, int time, int current, int temperature, int amount, int luminosity, double scale) : words{ 0, 0 }, scale(scale)
+{
+	const int powers[dim_count] = { mass, length, time, current, temperature, amount, luminosity };
+	for (int i = 0; i < dim_count; ++i) set_lane(i, to_lane(powers[i], 1));
+}
+
+dense_unit::dense_unit(const unit& u) : words{ 0, 0 }, scale(1)
+{
+	for (const base_unit& b : u.get_units()) {
+		if (b.get_power() == 1) *this *= lookup(b.get_id());
+		else { dense_unit d = lookup(b.get_id()); *this *= d.pow(b.get_power()); }
+	}
+}
+
+dense_unit::dense_unit(const str& str_units) : dense_unit(unit(str_units)) {}
+
+// Accessors
+
+void dense_unit::set_lane(int i, exponent e) noexcept
+{
+	int shift = 16 * (i % 4);
+	words[i / 4] = (words[i / 4] & ~(std::uint64_t(0xFFFF) << shift)) | (std::uint64_t(std::uint16_t(e)) << shift);
+}
+
+fraction dense_unit::get_power(si_dimension d) const { return fraction(get_lane(d), one).simplify(); }
+void dense_unit::set_power(si_dimension d, const fraction& power) { set_lane(d, to_lane(power.get_num(), power.get_den())); }
+
+// Functions
+
+void dense_unit::invert()
+{
+	std::uint64_t overflow = 0;
+	std::uint64_t w0 = sub_lanes(0, words[0], overflow), w1 = sub_lanes(0, words[1], overflow);
+	if (overflow) throw std::overflow_error("dense_unit: power out of range");
+	words[0] = w0; words[1] = w1; scale = 1 / scale;
+}
+
+dense_unit& dense_unit::pow(int p)
+{
+	dense_unit result(*this);
+	for (int i = 0; i < dim_count; ++i) result.set_lane(i, to_lane((long long)get_lane(si_dimension(i)) * p, one));
+	result.scale = std::pow(scale, p);
+	return *this = result;
+}
+
+dense_unit& dense_unit::pow(const fraction& p)
+{
+	dense_unit result(*this);
+	for (int i = 0; i < dim_count; ++i) result.set_lane(i, to_lane((long long)get_lane(si_dimension(i)) * p.get_num(), (long long)p.get_den() * one));
+	result.scale = std::pow(scale, p.to_double());
+	return *this = result;
+}
+
+// Halve every lane with an arithmetic shift: the bit shifted into the top of each lane is replaced by its sign.
+dense_unit& dense_unit::sqrt()
+{
+	if ((words[0] | words[1]) & low) throw std::domain_error("dense_unit: power is not a multiple of 1/256 after sqrt");
+	words[0] = ((words[0] >> 1) & ~high) | (words[0] & high);
+	words[1] = ((words[1] >> 1) & ~high) | (words[1] & high);
+	scale = std::sqrt(scale);
+	return *this;
+}
+
+// Type casts
+
+str dense_unit::to_string() const
+{
+	str s;
+	if (scale != 1) {
+		char buffer[32];
+		std::snprintf(buffer, sizeof(buffer), "%.15g", scale);
+		s = buffer;
+	}
+	for (int i = 0; i < dim_count; ++i) {
+		exponent e = get_lane(si_dimension(i));
+		if (e == 0) continue;
+		if (!s.empty()) s += " ";
+		s += dimension_symbols[i];
+		if (e != one) s += "^" + get_power(si_dimension(i)).to_string();
+	}
+	return s;
+}
+
+std::ostream& operator << (std::ostream& os, const dense_unit& rhs) {
+	os << rhs.to_string();
+	return os;
+}
@@ -1,32 +1,20 @@
 #include "stdafx.h"
 #include "unit.h"
+#include <algorithm>
+#include <mutex>
 
 // Construction 
 
-unit::unit() : units() {}
-unit::unit(const container &units) : units(units) {}
-unit::unit(const std::initializer_list<base_unit> &units) : units(units) {}
-unit::unit(str str_units) { set(str_units); }
-unit::unit(const unit& u) : units(u.units) {}			// copy constructor
-unit::unit(unit&& u) = default;							// move constructor
+unit::unit() : units(), hash_code(0) { rehash(); }
+unit::unit(const container &units) : units(units), hash_code(0) { normalize(); }
+unit::unit(const std::initializer_list<base_unit> &units) : units(units), hash_code(0) { normalize(); }
+unit::unit(str str_units) : hash_code(0) { set(str_units); }
+unit::unit(const unit& u) : units(u.units), hash_code(u.hash_code) {}		// copy constructor
+unit::unit(unit&& u) : units(std::move(u.units)), hash_code(u.hash_code) { u.units.clear(); u.rehash(); }		// move constructor: u is left empty, with the empty hash
 
 // Accessors
 			
-void unit::set(str str_units)
-{
-	int pos_space = str_units.find(" ");
-	if (pos_space == -1) units = { base_unit(str_units) };			// no space in units, therefore assume is a single unit
-	else
-	{
-		while (pos_space != -1)
-		{
-			units.push_back(base_unit(str_units.substr(0, pos_space)));
-			str_units = str_units.substr(pos_space + 1);
-			pos_space = str_units.find(" ");
-		}
-		units.push_back(base_unit(str_units));
-	}
-}
+void unit::set(str str_units) { units = *unit_cache::instance().get(str_units); rehash(); }		// cached in canonical form
 
 // Type casts
 
@@ -43,46 +31,80 @@ str unit::to_string() const
 	return s;
 }
 
-// Functions
+// Canonical form
 
-auto unit::contains_type(const str &unit_name)
-{
-	auto first = units.begin();
-	auto end = units.end();
+// The canonical order of symbols, which does not depend on the order they were interned (see symbol_registry::before)
+static bool by_symbol(const base_unit& lhs, const base_unit& rhs) { return symbol_registry::instance().before(lhs.get_id(), rhs.get_id()); }
 
-	for (; first != end; ++first)
-	{
-		if ((*first).get_unit() == unit_name)
-		{
-			return first;
-		}
+void unit::canonicalize(container &units)
+{
+	std::sort(units.begin(), units.end(), by_symbol);
+	auto out = units.begin();
+	for (auto it = units.begin(); it != units.end(); ) {
+		base_unit b = *it;
+		for (++it; it != units.end() && it->get_id() == b.get_id(); ++it) b *= *it;
+		b.get_power().simplify();
+		if (b.get_id() != 0 && b.get_power() != 0) *out++ = b;		// id 0 is the empty symbol, e.g. from a trailing space
 	}
-	return end;
-
+	units.erase(out, units.end());
 }
-void unit::mul_units(const unit &unit)
+
+void unit::normalize() { canonicalize(units); rehash(); }
+
+// Combines the symbol and power of each base unit, which are unique to a canonical unit (the powers are simplified).
+// The symbols are taken by their stable hash, so a unit has the same hash in every run.
+void unit::rehash() noexcept
 {
-	auto it_rhs = unit.units.begin();
-	auto end = unit.units.cend();
+	const symbol_registry& symbols = symbol_registry::instance();
+	std::uint64_t h = 0x84222325CBF29CE4ull ^ units.size();
+	for (const base_unit& b : units) {
+		std::uint64_t x = (symbols.stable_hash(b.get_id()) << 32) ^ (std::uint64_t(std::uint32_t(b.get_power().get_num())) << 16) ^ std::uint32_t(b.get_power().get_den());
+		h = (h ^ x) * 0x9E3779B97F4A7C15ull;
+		h ^= h >> 29;
+	}
+	hash_code = std::size_t(h);
+}
 
-	while (it_rhs != end) {
-		auto it = contains_type((*it_rhs).get_unit()); //std::find(units.begin(), units.end(), *it_rhs);
-		if (it != units.end()) {
-			(*it) *= *it_rhs;
-		}
+// Both lists are sorted, so walk them together: a base unit in only one is copied (negated from rhs if dividing),
+// and one in both has its powers added (or subtracted), and is dropped if they cancel.
+void unit::merge(const unit& rhs, bool divide)
+{
+	const symbol_registry& symbols = symbol_registry::instance();
+	container merged;
+	merged.reserve(units.size() + rhs.units.size());
+	auto a = units.cbegin(), a_end = units.cend();
+	auto b = rhs.units.cbegin(), b_end = rhs.units.cend();
+	while (a != a_end || b != b_end) {
+		if (b == b_end || (a != a_end && symbols.before(a->get_id(), b->get_id()))) merged.push_back(*a++);
+		else if (a == a_end || a->get_id() != b->get_id()) { merged.push_back(divide ? -*b : *b); ++b; }
 		else {
-			units.push_back(*it_rhs);
+			base_unit u = *a++;
+			if (divide) u /= *b++; else u *= *b++;
+			u.get_power().simplify();
+			if (u.get_power() != 0) merged.push_back(u);
 		}
-
-		++it_rhs;
 	}
+	units.swap(merged);
+	rehash();
 }
+
+// Functions
+
+container::const_iterator unit::find(symbol_id id) const
+{
+	auto it = std::lower_bound(units.begin(), units.end(), base_unit(id, fraction(1, 1)), by_symbol);
+	return it != units.end() && it->get_id() == id ? it : units.end();
+}
+container::const_iterator unit::contains_type(const str &unit_name) const { return find(symbol_registry::instance().intern(unit_name)); }
+
+void unit::mul_units(const unit &unit) { merge(unit, false); }
 void unit::invert() {
 	auto first = units.begin();
 	auto end = units.cend();
 	for (; first != end; ++first) {
 		(*first).invert();
 	}
+	rehash();
 }
 unit& unit::sqrt()
 {
@@ -92,28 +114,31 @@ unit& unit::sqrt()
 	{
 		*first = (*first).sqrt();
 	}
+	rehash();
 	return *this;
 }
 
 // Operator overloads : logical
 
-bool unit::operator  == (const unit& rhs) const { return equal<container>(units, rhs.units); }
+bool unit::operator  == (const unit& rhs) const { return hash_code == rhs.hash_code && units == rhs.units; }
 bool unit::operator  != (const unit& rhs) const { return !operator==(rhs); }
 
 // Operator overloads : increment and decrement
 
 unit  unit::operator  -() const
 {
-	unit f(units);
+	unit f(*this);
 	f.invert();
 	return f;
 }
 unit& unit::operator ++() {
 	inc(units.begin(), units.cend());
+	normalize();
 	return *this;
 }
 unit& unit::operator --() {
 	dec(units.begin(), units.cend());
+	normalize();
 	return *this;
 }
 const unit unit::operator ++(int unused) {
@@ -129,11 +154,11 @@ const unit unit::operator --(int unused) {
 
 // Operator overloads : arithmetic
 
-unit& unit::operator  = (unit rhs) noexcept { std::swap(*this, rhs); return *this; }
-unit& unit::operator += (const unit& rhs) { EQ(units, rhs.units); return *this; }
-unit& unit::operator -= (const unit& rhs) { EQ(units, rhs.units); return *this; }
-unit& unit::operator *= (const unit& rhs) { mul_units(rhs); return *this; }
-unit& unit::operator /= (const unit& rhs) { *this *= -rhs; return *this; }
+unit& unit::operator  = (unit rhs) noexcept { swap(rhs); return *this; }
+unit& unit::operator += (const unit& rhs) { EQ(*this, rhs); return *this; }
+unit& unit::operator -= (const unit& rhs) { EQ(*this, rhs); return *this; }
+unit& unit::operator *= (const unit& rhs) { merge(rhs, false); return *this; }
+unit& unit::operator /= (const unit& rhs) { merge(rhs, true); return *this; }
 
 // Operator overloads : rhs arithmetic
 
@@ -153,3 +178,47 @@ std::istream& operator >> (std::istream& in, unit& rhs) {
 	return in;
 }
 
+// Parse cache
+//------------------------------------------------------------------------------------
+
+unit_cache& unit_cache::instance() { static unit_cache cache; return cache; }
+
+// The base units are separated by single spaces. The result is in canonical form.
+container unit_cache::parse(const str& str_units)
+{
+	container units;
+	std::size_t first = 0;
+	for (;;) {
+		std::size_t space = str_units.find(' ', first);
+		units.push_back(base_unit(str_units.substr(first, space == str::npos ? str::npos : space - first)));
+		if (space == str::npos) break;
+		first = space + 1;
+	}
+	unit::canonicalize(units);
+	return units;
+}
+
+std::shared_ptr<const container> unit_cache::get(const str& str_units)
+{
+	{
+		std::shared_lock<std::shared_mutex> lock(mutex);
+		auto found = parsed.find(str_units);
+		if (found != parsed.end()) { hit_count.fetch_add(1, std::memory_order_relaxed); return found->second; }
+	}
+	miss_count.fetch_add(1, std::memory_order_relaxed);
+	std::shared_ptr<const container> units = std::make_shared<const container>(parse(str_units));		// outside the lock
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	return parsed.emplace(str_units, std::move(units)).first->second;		// or the one another thread added first
+}
+
+std::size_t unit_cache::size() const
+{
+	std::shared_lock<std::shared_mutex> lock(mutex);
+	return parsed.size();
+}
+
+void unit_cache::clear()
+{
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	parsed.clear();
+}
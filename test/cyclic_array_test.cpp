@@ -0,0 +1,68 @@
+/*	Checks that cyclic_array<int> gives exactly the results of cyclic<int>, for every instruction set this machine has
+	(scalar, AVX2 and AVX-512 kernels), for += and -= of a scalar and of an array, over small ranges, ranges of more than
+	half of int (where adding first would overflow), and the whole of int. Returns non-zero on any difference.
+	A standalone program, e.g.
+		g++ -std=c++17 -O2 -Iinclude test/cyclic_array_test.cpp lib/bound_array.cpp -o cyclic_array_test
+*/
+
+#include <climits>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "bound_array.h"
+#include "cyclic.h"
+
+static long failures = 0;
+
+// Runs one operation through the kernels of isa, and through cyclic<int> value by value
+static void check(simd_isa isa, bound_op op, int min, int max, const std::vector<int>& values, const std::vector<int>& rhs, bool array)
+{
+	std::vector<int> kernel(values);
+	bound_kernels<int>::get(isa).wrap(kernel.data(), array ? rhs.data() : nullptr, rhs[0], op, min, max, kernel.size());
+
+	for (std::size_t i = 0; i < values.size(); ++i) {
+		cyclic<int> c(values[i], min, max);
+		int r = array ? rhs[i] : rhs[0];
+		if (op == op_add) c += r; else c -= r;
+		if (c.get() != kernel[i] && ++failures <= 10)
+			std::printf("isa %d, [%d, %d]: %d %s %d gives %d, cyclic<int> gives %d\n", int(isa), min, max, values[i], op == op_add ? "+" : "-", r, kernel[i], c.get());
+	}
+}
+
+int main()
+{
+	std::mt19937 random(7);
+	std::uniform_int_distribution<int> any(INT_MIN, INT_MAX);
+
+	// The case that first showed the difference: 1900000000 + 1000000000 in [0, 2000000000] is 899999999
+	{
+		std::vector<int> values(37, 1900000000), rhs(37, 1000000000);
+		for (int isa = isa_scalar; isa <= int(active_isa()); ++isa) check(simd_isa(isa), op_add, 0, 2000000000, values, rhs, false);
+		cyclic_array<int> a(37, 1900000000, 0, 2000000000);
+		a += 1000000000;
+		for (std::size_t i = 0; i < a.size(); ++i) if (a[i] != 899999999 && ++failures <= 10) std::printf("cyclic_array: %d, expected 899999999\n", a[i]);
+	}
+
+	for (int round = 0; round < 2000; ++round) {
+		int min, max;
+		switch (round % 4) {
+		case 0: min = any(random) / 2; max = min + int(random() % 100); break;				// small
+		case 1: min = INT_MIN + int(random() % 1000); max = INT_MAX - int(random() % 1000); break;	// nearly all of int
+		case 2: min = -int(random() % 1000); max = 2000000000; break;						// more than half of int
+		default: min = INT_MIN; max = INT_MAX; break;										// all of int
+		}
+		std::size_t n = 1 + random() % 70;		// whole vectors and tails
+		std::uniform_int_distribution<int> inside(min, max);
+		std::vector<int> values(n), rhs(n);
+		for (std::size_t i = 0; i < n; ++i) {
+			values[i] = inside(random);
+			rhs[i] = random() % 3 == 0 ? int(random() % 21) - 10 : any(random);
+		}
+		for (int isa = isa_scalar; isa <= int(active_isa()); ++isa)
+			for (bound_op op : { op_add, op_sub })
+				for (bool array : { false, true }) check(simd_isa(isa), op, min, max, values, rhs, array);
+	}
+
+	std::printf(failures ? "%ld differences\n" : "cyclic_array<int> matches cyclic<int>\n", failures);
+	return failures != 0;
+}